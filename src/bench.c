@@ -0,0 +1,640 @@
+/*
+ Copyright (c) 2015 Ricardo Iván Vieitez Parra
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "utilities.h"
+#include "project1.h"
+#include "precision.h"
+#include "thread_pool.h"
+
+/* project1_bench [--json FILE] [--warmup N] [--repetitions N] [--filter TEXT]
+ *
+ * Times each routine in isolation: every benchmark runs warmup untimed times
+ * and then repetitions timed ones, and reports the median, 10th and 90th
+ * percentiles and the median time per element. --json also writes every
+ * record to FILE (- for stdout, moving the table to stderr) so runs can be compared between versions;
+ * --filter only runs the benchmarks whose name contains TEXT. */
+
+#define BENCH_POINTS 524289L
+#define BENCH_EVALUATION_POINTS 65536L
+#define BENCH_SQUARE_ROOTS 1048576L
+#define BENCH_WARMUP 1
+#define BENCH_REPETITIONS 5
+#define BENCH_MAX_REPETITIONS 1000
+
+static struct {
+    int warmup;
+    int repetitions;
+    char const* filter;
+    FILE* json;
+    /* stderr when the JSON goes to stdout */
+    FILE* report;
+    size_t records;
+} options = {
+    BENCH_WARMUP,
+    BENCH_REPETITIONS,
+    NULL,
+    NULL,
+    NULL,
+    0
+};
+
+/* Keeps the results of scalar loops alive */
+static volatile long double sink;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1E-9;
+}
+
+static int compare_times(void const * const a, void const * const b)
+{
+    double const x = *(double const*)a, y = *(double const*)b;
+    return (x > y) - (x < y);
+}
+
+/* Linear interpolation between the closest ranks of sorted times */
+static double percentile(double const * const times, size_t const n, double const p)
+{
+    double const rank = p * (double)(n - 1);
+    size_t const i = (size_t)rank;
+    return (i + 1 < n) ? times[i] + (rank - (double)i) * (times[i + 1] - times[i]) : times[n - 1];
+}
+
+static void bench(char const * const name, char const * const parameters, size_t const elements, void (* const body)(void*), void * const arg)
+{
+    if(options.filter != NULL && strstr(name, options.filter) == NULL) {
+        return;
+    }
+    double times[BENCH_MAX_REPETITIONS];
+    for(int r = 0; r != options.warmup; r++) {
+        body(arg);
+    }
+    for(int r = 0; r != options.repetitions; r++) {
+        double const start = now();
+        body(arg);
+        times[r] = now() - start;
+    }
+    size_t const n = (size_t)options.repetitions;
+    qsort(times, n, sizeof(double), compare_times);
+    double const median = percentile(times, n, 0.5);
+    double const p10 = percentile(times, n, 0.1);
+    double const p90 = percentile(times, n, 0.9);
+    double const per_element = median * 1E9 / (double)elements;
+
+    fprintf(options.report, "%-40s %-18s %11.3f ms (p10 %11.3f, p90 %11.3f) %12.2f ns/element\n", name, parameters, median * 1E3, p10 * 1E3, p90 * 1E3, per_element);
+    fflush(options.report);
+    if(options.json != NULL) {
+        fprintf(options.json, "%s\n    {\"name\": \"%s\", \"parameters\": \"%s\", \"elements\": %lu, \"repetitions\": %d, "
+                "\"min_ns\": %.0f, \"p10_ns\": %.0f, \"median_ns\": %.0f, \"p90_ns\": %.0f, \"max_ns\": %.0f, \"ns_per_element\": %.3f}",
+                (options.records == 0) ? "" : ",", name, parameters, elements, options.repetitions,
+                times[0] * 1E9, p10 * 1E9, median * 1E9, p90 * 1E9, times[n - 1] * 1E9, per_element);
+    }
+    options.records++;
+}
+
+/* Functions the benchmarks work on, the same as in main */
+static long double f(long double x)
+{
+    return expl(-x / 5.0L) - sinl(x);
+}
+
+static long double f_derivative(long double x)
+{
+    return -expl(-x / 5.0L) / 5.0L - cosl(x);
+}
+
+static long double f_secondderivative(long double x)
+{
+    return expl(-x / 5.0L) / 25.0L + sinl(x);
+}
+
+static long double h(long double x)
+{
+    return 1.0L / (powl(x, 2.0L) + 1.0L);
+}
+
+static long double h_derivative(long double x)
+{
+    return -2.0L * x / powl(powl(x, 2.0L) + 1.0L, 2.0L);
+}
+
+static struct function const root_function = {
+    "e**(-x/5)/sin(x)",
+    (long double(*)(long double, void const*))f,
+    NULL
+};
+
+static struct function const root_function_derivative = {
+    "(e**(-x/5)/sin(x))'",
+    (long double(*)(long double, void const*))f_derivative,
+    NULL
+};
+
+static struct function const root_function_secondderivative = {
+    "(e**(-x/5)/sin(x))''",
+    (long double(*)(long double, void const*))f_secondderivative,
+    NULL
+};
+
+static struct function const interpolation_function = {
+    "1/(1+x**2)",
+    (long double(*)(long double, void const*))h,
+    NULL
+};
+
+static struct function const interpolation_function_derivative = {
+    "-2x/(1+x**2)**2",
+    (long double(*)(long double, void const*))h_derivative,
+    NULL
+};
+
+/* Sampling */
+
+struct sample_bench {
+    long double sampling_interval;
+};
+
+static void sample_body(void * const arg)
+{
+    struct sample_bench const * const job = arg;
+    destroy_sample(sample_values(&interpolation_function, -5.0L, 5.0L, job->sampling_interval));
+}
+
+static void bench_sampling(void)
+{
+    size_t const points[] = {4096, 65536, BENCH_POINTS - 1};
+    for(size_t i = 0; i != sizeof(points) / sizeof(points[0]); i++) {
+        char parameters[32];
+        struct sample_bench job = {10.0L / (long double)points[i]};
+        snprintf(parameters, sizeof(parameters), "points=%lu", points[i] + 1);
+        bench("sample_values", parameters, points[i] + 1, sample_body, &job);
+    }
+}
+
+/* Matrices */
+
+/* Fill a matrix with a deterministic pattern in [-1, 1] */
+static void fill_matrix(struct matrix * const matrix)
+{
+    for(size_t i = 0; i < matrix->rows * matrix->cols; i++) {
+        matrix->elements[i] = sinl((long double)i * 0.37L);
+    }
+}
+
+struct multiply_bench {
+    struct matrix*(*multiply)(struct matrix const*, struct matrix const*);
+    struct matrix const* A;
+    struct matrix const* B;
+    size_t m;
+    size_t n;
+    size_t k;
+    double const* Ad;
+    double const* Bd;
+    double* Cd;
+};
+
+static void multiply_body(void * const arg)
+{
+    struct multiply_bench const * const job = arg;
+    destroy_matrix(job->multiply(job->A, job->B));
+}
+
+static void multiply_double_body(void * const arg)
+{
+    struct multiply_bench const * const job = arg;
+    matrix_multiply_double(job->m, job->n, job->k, job->Ad, job->Bd, job->Cd);
+}
+
+static void bench_gemm_shape(char const * const shape, size_t const m, size_t const n, size_t const k)
+{
+    struct matrix * const A = create_matrix(k, m);
+    struct matrix * const B = create_matrix(n, k);
+    double * const Ad = malloc(sizeof(double) * m * k);
+    double * const Bd = malloc(sizeof(double) * k * n);
+    double * const Cd = malloc(sizeof(double) * m * n);
+    if(A == NULL || B == NULL || Ad == NULL || Bd == NULL || Cd == NULL) {
+        fprintf(stderr, "bench_gemm_shape(): Unable to allocate memory.\n");
+        exit(EXIT_FAILURE);
+    }
+    fill_matrix(A);
+    fill_matrix(B);
+    for(size_t i = 0; i < m * k; i++) {
+        Ad[i] = (double)A->elements[i];
+    }
+    for(size_t i = 0; i < k * n; i++) {
+        Bd[i] = (double)B->elements[i];
+    }
+
+    char parameters[64];
+    snprintf(parameters, sizeof(parameters), "%s %lux%lux%lu", shape, m, n, k);
+    struct multiply_bench job = {matrix_multiply_naive, A, B, m, n, k, Ad, Bd, Cd};
+    bench("matrix_multiply_naive", parameters, m * n * k, multiply_body, &job);
+    job.multiply = matrix_multiply;
+    bench("matrix_multiply", parameters, m * n * k, multiply_body, &job);
+    bench("matrix_multiply_double", parameters, m * n * k, multiply_double_body, &job);
+
+    destroy_matrix(A);
+    destroy_matrix(B);
+    free(Ad);
+    free(Bd);
+    free(Cd);
+}
+
+static void inverse_body(void * const arg)
+{
+    destroy_matrix(matrix_inverse(arg));
+}
+
+static void bench_matrices(void)
+{
+    size_t const orders[] = {5, 10, 20};
+    for(size_t i = 0; i != sizeof(orders) / sizeof(orders[0]); i++) {
+        size_t const n = orders[i] + 1;
+        bench_gemm_shape("V_T*V", n, n, BENCH_POINTS);
+        bench_gemm_shape("inverse*V_T", n, BENCH_POINTS, n);
+        bench_gemm_shape("(...)*f_T", n, 1, BENCH_POINTS);
+    }
+
+    size_t const sizes[] = {6, 11, 21, 64, 256};
+    for(size_t i = 0; i != sizeof(sizes) / sizeof(sizes[0]); i++) {
+        size_t const n = sizes[i];
+        struct matrix * const A = create_matrix(n, n);
+        if(A == NULL) {
+            exit(EXIT_FAILURE);
+        }
+        /* Diagonally dominant, so always invertible */
+        fill_matrix(A);
+        for(size_t j = 0; j != n; j++) {
+            A->elements[j * n + j] += (long double)n;
+        }
+        char parameters[32];
+        snprintf(parameters, sizeof(parameters), "n=%lu", n);
+        bench("matrix_inverse", parameters, n * n * n, inverse_body, A);
+        destroy_matrix(A);
+    }
+}
+
+/* Interpolation */
+
+enum bench_interpolation {
+    BENCH_LAGRANGE,
+    BENCH_BARYCENTRIC_UNIFORM,
+    BENCH_BARYCENTRIC_CHEBYSHEV,
+    BENCH_CHEBYSHEV,
+    BENCH_PIECEWISE_LINEAR,
+    BENCH_RAISED_COSINE,
+    BENCH_CUBIC_SPLINE_NATURAL,
+    BENCH_CUBIC_SPLINE_CLAMPED,
+    BENCH_LEAST_SQUARES,
+    BENCH_STREAMING_LEAST_SQUARES,
+    BENCH_INTERPOLATIONS
+};
+
+static struct {
+    char const* name;
+    long double (*value)(long double, struct interpolation const*);
+    void (*values)(long double const*, long double*, size_t, struct interpolation const*);
+    long double (*error)(struct interpolation const*);
+} const interpolations[BENCH_INTERPOLATIONS] = {
+    {"lagrange", polynomial_value, polynomial_values, polynomial_error},
+    {"barycentric_uniform", barycentric_value, barycentric_values, barycentric_error},
+    {"barycentric_chebyshev", barycentric_value, barycentric_values, barycentric_error},
+    {"chebyshev", chebyshev_value, chebyshev_values, chebyshev_error},
+    {"piecewise_linear", piecewise_linear_value, piecewise_linear_values, piecewise_linear_error},
+    {"raised_cosine", raised_cosine_value, raised_cosine_values, raised_cosine_error},
+    {"cubic_spline_natural", cubic_spline_value, cubic_spline_values, cubic_spline_error},
+    {"cubic_spline_clamped", cubic_spline_value, cubic_spline_values, cubic_spline_error},
+    {"least_squares", polynomial_value, polynomial_values, polynomial_error},
+    {"streaming_least_squares", polynomial_value, polynomial_values, polynomial_error}
+};
+
+static struct interpolation const* create_bench_interpolation(enum bench_interpolation const kind, size_t const order)
+{
+    switch(kind) {
+        case BENCH_LAGRANGE:
+            return lagrange_interpolation(&interpolation_function, -5.0L, 5.0L, order);
+        case BENCH_BARYCENTRIC_UNIFORM:
+            return barycentric_lagrange_interpolation(&interpolation_function, -5.0L, 5.0L, order, INTERPOLATION_NODES_UNIFORM);
+        case BENCH_BARYCENTRIC_CHEBYSHEV:
+            return barycentric_lagrange_interpolation(&interpolation_function, -5.0L, 5.0L, order, INTERPOLATION_NODES_CHEBYSHEV);
+        case BENCH_CHEBYSHEV:
+            return chebyshev_interpolation(&interpolation_function, -5.0L, 5.0L, order);
+        case BENCH_PIECEWISE_LINEAR:
+            return piecewise_linear_interpolation(&interpolation_function, -5.0L, 5.0L, order);
+        case BENCH_RAISED_COSINE:
+            return raised_cosine_interpolation(&interpolation_function, -5.0L, 5.0L, order);
+        case BENCH_CUBIC_SPLINE_NATURAL:
+            return cubic_spline_interpolation(&interpolation_function, NULL, -5.0L, 5.0L, order);
+        case BENCH_CUBIC_SPLINE_CLAMPED:
+            return cubic_spline_interpolation(&interpolation_function, &interpolation_function_derivative, -5.0L, 5.0L, order);
+        case BENCH_LEAST_SQUARES:
+            return least_squares_interpolation(&interpolation_function, -5.0L, 5.0L, order);
+        default:
+            return streaming_least_squares_interpolation(&interpolation_function, -5.0L, 5.0L, order, BENCH_POINTS - 1);
+    }
+}
+
+struct interpolation_bench {
+    enum bench_interpolation kind;
+    size_t order;
+    struct interpolation const* interpolation;
+    long double const* x;
+    long double* y;
+    size_t n;
+};
+
+static void construct_body(void * const arg)
+{
+    struct interpolation_bench const * const job = arg;
+    destroy_interpolation((struct interpolation*)create_bench_interpolation(job->kind, job->order));
+}
+
+static void value_body(void * const arg)
+{
+    struct interpolation_bench const * const job = arg;
+    long double sum = 0.0L;
+    for(size_t i = 0; i != job->n; i++) {
+        sum += interpolations[job->kind].value(job->x[i], job->interpolation);
+    }
+    sink = sum;
+}
+
+static void values_body(void * const arg)
+{
+    struct interpolation_bench const * const job = arg;
+    interpolations[job->kind].values(job->x, job->y, job->n, job->interpolation);
+}
+
+static void error_body(void * const arg)
+{
+    struct interpolation_bench const * const job = arg;
+    sink = interpolations[job->kind].error(job->interpolation);
+}
+
+static void bench_interpolations(void)
+{
+    size_t const orders[] = {5, 10, 20};
+    long double * const x = malloc(sizeof(long double) * BENCH_EVALUATION_POINTS);
+    long double * const y = malloc(sizeof(long double) * BENCH_EVALUATION_POINTS);
+    if(x == NULL || y == NULL) {
+        fprintf(stderr, "bench_interpolations(): Unable to allocate memory.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(size_t i = 0; i != BENCH_EVALUATION_POINTS; i++) {
+        x[i] = -5.0L + 10.0L * (long double)i / (long double)(BENCH_EVALUATION_POINTS - 1);
+    }
+
+    for(int kind = 0; kind != BENCH_INTERPOLATIONS; kind++) {
+        char name[64];
+        for(size_t i = 0; i != sizeof(orders) / sizeof(orders[0]); i++) {
+            char parameters[32];
+            struct interpolation_bench job = {kind, orders[i], NULL, x, y, BENCH_EVALUATION_POINTS};
+            size_t const samples = (kind == BENCH_LEAST_SQUARES || kind == BENCH_STREAMING_LEAST_SQUARES) ? BENCH_POINTS : orders[i] + 1;
+            snprintf(parameters, sizeof(parameters), "order=%lu", orders[i]);
+
+            snprintf(name, sizeof(name), "%s_interpolation", interpolations[kind].name);
+            bench(name, parameters, samples, construct_body, &job);
+
+            job.interpolation = create_bench_interpolation(kind, orders[i]);
+            if(job.interpolation == NULL) {
+                exit(EXIT_FAILURE);
+            }
+            snprintf(name, sizeof(name), "%s_value", interpolations[kind].name);
+            bench(name, parameters, BENCH_EVALUATION_POINTS, value_body, &job);
+            snprintf(name, sizeof(name), "%s_values", interpolations[kind].name);
+            bench(name, parameters, BENCH_EVALUATION_POINTS, values_body, &job);
+            /* The *_error() functions run function_error() on order * 524288 + 1 points */
+            snprintf(name, sizeof(name), "%s_error", interpolations[kind].name);
+            bench(name, parameters, orders[i] * 524288L + 1, error_body, &job);
+            destroy_interpolation((struct interpolation*)job.interpolation);
+        }
+    }
+    free(x);
+    free(y);
+}
+
+/* Root finding */
+
+enum bench_solver {
+    BENCH_BISECTION,
+    BENCH_MULTI_BISECTION,
+    BENCH_BRENT,
+    BENCH_ILLINOIS,
+    BENCH_SECANT,
+    BENCH_NEWTON,
+    BENCH_ALTERED_NEWTON,
+    BENCH_SOLVERS
+};
+
+static char const * const solver_names[BENCH_SOLVERS] = {
+    "bisection_method",
+    "multi_bisection_method",
+    "brent_method",
+    "illinois_method",
+    "secant_method",
+    "newtons_method",
+    "altered_newtons_method"
+};
+
+static long double const bracket_lower[] = {0.5L, 2.0L, 6.0L, 9.0L};
+static long double const bracket_upper[] = {1.5L, 3.0L, 7.0L, 10.0L};
+static long double const newton_start[] = {1.0L, 2.5L, 6.5L, 9.9L};
+
+static void solver_body(void * const arg)
+{
+    enum bench_solver const solver = *(enum bench_solver const*)arg;
+    long double sum = 0.0L;
+    if(solver == BENCH_MULTI_BISECTION) {
+        struct result * const results = multi_bisection_method(&root_function, bracket_lower, bracket_upper, 4, 1E-7L);
+        for(int i = 0; i != 4 && results != NULL; i++) {
+            sum += results[i].value;
+        }
+        free(results);
+        sink = sum;
+        return;
+    }
+    for(int i = 0; i != 4; i++) {
+        struct result result;
+        switch(solver) {
+            case BENCH_BISECTION:
+                result = bisection_method(&root_function, bracket_lower[i], bracket_upper[i], 1E-7L);
+                break;
+            case BENCH_BRENT:
+                result = brent_method(&root_function, bracket_lower[i], bracket_upper[i], 1E-7L);
+                break;
+            case BENCH_ILLINOIS:
+                result = illinois_method(&root_function, bracket_lower[i], bracket_upper[i], 1E-7L);
+                break;
+            case BENCH_SECANT:
+                result = secant_method(&root_function, bracket_lower[i], bracket_upper[i], 256, 1E-7L);
+                break;
+            case BENCH_NEWTON:
+                result = newtons_method(&root_function, &root_function_derivative, newton_start[i], 256, 1E-7L);
+                break;
+            default:
+                result = altered_newtons_method(&root_function, &root_function_derivative, &root_function_secondderivative, newton_start[i], 256, 1E-7L);
+                break;
+        }
+        sum += result.value;
+    }
+    sink = sum;
+}
+
+struct find_roots_bench {
+    long double end;
+    size_t steps;
+};
+
+static void find_roots_body(void * const arg)
+{
+    struct find_roots_bench const * const job = arg;
+    size_t count;
+    free(find_roots(&root_function, NULL, 0.0L, job->end, job->steps, 1E-7L, &count));
+}
+
+struct square_root_bench {
+    long double* k;
+    struct result* results;
+    size_t n;
+};
+
+static void square_root_values_body(void * const arg)
+{
+    struct square_root_bench const * const job = arg;
+    square_root_values(job->k, job->results, job->n);
+}
+
+static void square_root_calculator_body(void * const arg)
+{
+    struct square_root_bench const * const job = arg;
+    long double sum = 0.0L;
+    for(size_t i = 0; i != job->n; i++) {
+        sum += square_root_calculator(job->k[i]).value;
+    }
+    sink = sum;
+}
+
+static void bench_roots(void)
+{
+    for(int solver = 0; solver != BENCH_SOLVERS; solver++) {
+        enum bench_solver const s = solver;
+        bench(solver_names[solver], "roots=4", 4, solver_body, (void*)&s);
+    }
+
+    struct find_roots_bench const scans[] = {
+        {10.0L, 1024},
+        {1000.0L, 1048576}
+    };
+    for(size_t i = 0; i != sizeof(scans) / sizeof(scans[0]); i++) {
+        char parameters[32];
+        snprintf(parameters, sizeof(parameters), "steps=%lu", scans[i].steps);
+        bench("find_roots", parameters, scans[i].steps, find_roots_body, (void*)&scans[i]);
+    }
+
+    struct square_root_bench job = {
+        malloc(sizeof(long double) * BENCH_SQUARE_ROOTS),
+        malloc(sizeof(struct result) * BENCH_SQUARE_ROOTS),
+        BENCH_SQUARE_ROOTS
+    };
+    if(job.k == NULL || job.results == NULL) {
+        fprintf(stderr, "bench_roots(): Unable to allocate memory.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(size_t i = 0; i != BENCH_SQUARE_ROOTS; i++) {
+        job.k[i] = 10.0L + (long double)i / 8192.0L;
+    }
+    char parameters[32];
+    snprintf(parameters, sizeof(parameters), "n=%lu", job.n);
+    bench("square_root_values", parameters, job.n, square_root_values_body, &job);
+    job.n = BENCH_SQUARE_ROOTS / 256;
+    snprintf(parameters, sizeof(parameters), "n=%lu", job.n);
+    bench("square_root_calculator", parameters, job.n, square_root_calculator_body, &job);
+    free(job.k);
+    free(job.results);
+}
+
+static void usage(char const * const name)
+{
+    fprintf(stderr, "Usage: %s [--json FILE] [--warmup N] [--repetitions N] [--filter TEXT]\n", name);
+}
+
+int main(int argc, char** argv)
+{
+    char const* json = NULL;
+    for(int i = 1; i < argc; i++) {
+        if(i + 1 == argc) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        if(strcmp(argv[i], "--json") == 0) {
+            json = argv[++i];
+        } else if(strcmp(argv[i], "--warmup") == 0) {
+            options.warmup = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--repetitions") == 0) {
+            options.repetitions = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--filter") == 0) {
+            options.filter = argv[++i];
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if(options.warmup < 0 || options.repetitions < 1 || options.repetitions > BENCH_MAX_REPETITIONS) {
+        fprintf(stderr, "%s: warmup must be at least 0 and repetitions between 1 and %d\n", argv[0], BENCH_MAX_REPETITIONS);
+        return EXIT_FAILURE;
+    }
+    if(json != NULL) {
+        options.json = (strcmp(json, "-") == 0) ? stdout : fopen(json, "w");
+        if(options.json == NULL) {
+            fprintf(stderr, "%s: Unable to open %s\n", argv[0], json);
+            return EXIT_FAILURE;
+        }
+        fprintf(options.json, "{\n  \"threads\": %lu,\n  \"precision\": \"%s\",\n  \"matrix_multiply_double_kernel\": \"%s\",\n  \"warmup\": %d,\n  \"benchmarks\": [",
+                thread_pool_threads(), precision_name(get_precision()), matrix_multiply_double_kernel(), options.warmup);
+    }
+
+    options.report = (options.json == stdout) ? stderr : stdout;
+    fprintf(options.report, "project1_bench: %lu threads, %s, %d warmup, %d repetitions\n", thread_pool_threads(), precision_name(get_precision()), options.warmup, options.repetitions);
+    bench_sampling();
+    bench_matrices();
+    bench_interpolations();
+    bench_roots();
+
+    if(options.json != NULL) {
+        fprintf(options.json, "\n  ]\n}\n");
+        if(options.json != stdout) {
+            fclose(options.json);
+        }
+    }
+    return EXIT_SUCCESS;
+}
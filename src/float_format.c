@@ -0,0 +1,206 @@
+/*
+ Copyright (c) 2015 Ricardo Iván Vieitez Parra
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <locale.h>
+#include <pthread.h>
+#include "float_format.h"
+
+static uint64_t const powers_of_ten[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL,
+    1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+    1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+    1000000000000000000ULL
+};
+
+/* 10**k = scale_large[q + 11] * scale_small[k - 32 * q] with q = floor(k / 32) */
+static long double const scale_small[32] = {
+    1E0L, 1E1L, 1E2L, 1E3L, 1E4L, 1E5L, 1E6L, 1E7L,
+    1E8L, 1E9L, 1E10L, 1E11L, 1E12L, 1E13L, 1E14L, 1E15L,
+    1E16L, 1E17L, 1E18L, 1E19L, 1E20L, 1E21L, 1E22L, 1E23L,
+    1E24L, 1E25L, 1E26L, 1E27L, 1E28L, 1E29L, 1E30L, 1E31L
+};
+static long double const scale_large[23] = {
+    1E-352L, 1E-320L, 1E-288L, 1E-256L, 1E-224L, 1E-192L,
+    1E-160L, 1E-128L, 1E-96L, 1E-64L, 1E-32L, 1E0L,
+    1E32L, 1E64L, 1E96L, 1E128L, 1E160L, 1E192L,
+    1E224L, 1E256L, 1E288L, 1E320L, 1E352L
+};
+
+static long double power_of_ten(int const k)
+{
+    int const q = (k >= 0) ? k / 32 : -((31 - k) / 32);
+    return scale_large[q + 11] * scale_small[k - 32 * q];
+}
+
+/* Writes digits (exactly n of them, trailing zeros dropped) as d.dddE<exponent> */
+static size_t write_scientific(char * const buffer, char const negative, uint64_t digits, size_t n, int const exponent)
+{
+    char text[20];
+    size_t length = 0;
+    while(n > 1 && digits % 10 == 0) {
+        digits /= 10;
+        n--;
+    }
+    for(size_t i = n; i != 0; i--) {
+        text[i - 1] = (char)('0' + digits % 10);
+        digits /= 10;
+    }
+    if(negative) {
+        buffer[length++] = '-';
+    }
+    buffer[length++] = text[0];
+    if(n > 1) {
+        buffer[length++] = '.';
+        memcpy(buffer + length, text + 1, n - 1);
+        length += n - 1;
+    }
+    buffer[length++] = 'E';
+    int e = exponent;
+    if(e < 0) {
+        buffer[length++] = '-';
+        e = -e;
+    }
+    char exponent_text[4];
+    size_t exponent_length = 0;
+    do {
+        exponent_text[exponent_length++] = (char)('0' + e % 10);
+        e /= 10;
+    } while(e != 0);
+    while(exponent_length != 0) {
+        buffer[length++] = exponent_text[--exponent_length];
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+/* The "C" locale, so that strtod() and snprintf() use '.' whatever
+ * setlocale() the program made. (locale_t)0 if it could not be created,
+ * which uselocale() takes as leaving the locale alone. */
+static locale_t c_locale;
+static pthread_once_t c_locale_once = PTHREAD_ONCE_INIT;
+
+static void create_c_locale(void)
+{
+    c_locale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+}
+
+static locale_t use_c_locale(void)
+{
+    pthread_once(&c_locale_once, create_c_locale);
+    return uselocale(c_locale);
+}
+
+/* |value| is scaled by a power of ten to an 18 digit integer in long double,
+ * together with the bounds of the interval of reals that round to value.
+ * The shortest truncation of the digits, rounded up or down, that falls
+ * inside the interval is the answer. The long double error is far below one unit of the 18th digit;
+ * candidates that close to a bound are checked with strtod() instead, and
+ * snprintf() is the last resort. */
+size_t format_double(double const value, char * const buffer)
+{
+    if(isnan(value)) {
+        strcpy(buffer, "nan");
+        return 3;
+    }
+    if(isinf(value)) {
+        strcpy(buffer, value < 0.0 ? "-inf" : "inf");
+        return value < 0.0 ? 4 : 3;
+    }
+    if(value == 0.0) {
+        strcpy(buffer, signbit(value) ? "-0" : "0");
+        return signbit(value) ? 2 : 1;
+    }
+    char const negative = value < 0.0;
+    double const magnitude = fabs(value);
+    int binary_exponent;
+    double const mantissa = frexp(magnitude, &binary_exponent);
+    if(binary_exponent < DBL_MIN_EXP) {
+        binary_exponent = DBL_MIN_EXP;
+    }
+    /* Half the distance to the neighbouring doubles */
+    long double const half_above = ldexpl(1.0L, binary_exponent - DBL_MANT_DIG - 1);
+    long double const half_below = (mantissa == 0.5 && binary_exponent > DBL_MIN_EXP) ? 0.5L * half_above : half_above;
+
+    int exponent = (int)floor(log10(magnitude));
+    long double scale = power_of_ten(17 - exponent);
+    long double scaled = (long double)magnitude * scale;
+    if(scaled >= 1E18L) {
+        exponent++;
+        scale = power_of_ten(17 - exponent);
+        scaled = (long double)magnitude * scale;
+    } else if(scaled < 1E17L) {
+        exponent--;
+        scale = power_of_ten(17 - exponent);
+        scaled = (long double)magnitude * scale;
+    }
+    long double const low = scaled - half_below * scale, high = scaled + half_above * scale;
+    long double const margin = scaled * 0x1P-58L;
+    uint64_t const digits = (uint64_t)llrintl(scaled);
+
+    for(size_t n = 1; n <= 17; n++) {
+        uint64_t const divisor = powers_of_ten[18 - n];
+        uint64_t const down = digits / divisor;
+        /* Both neighbours at this length, nearest first */
+        uint64_t const candidates[2] = {
+            (digits - down * divisor < divisor / 2) ? down : down + 1,
+            (digits - down * divisor < divisor / 2) ? down + 1 : down
+        };
+        for(size_t c = 0; c != 2; c++) {
+            uint64_t candidate = candidates[c];
+            long double const candidate_scaled = (long double)candidate * (long double)divisor;
+            if(candidate == 0 || candidate_scaled <= low - margin || candidate_scaled >= high + margin) {
+                continue;
+            }
+            int candidate_exponent = exponent;
+            size_t candidate_n = n;
+            if(candidate == powers_of_ten[n]) {
+                candidate = 1;
+                candidate_n = 1;
+                candidate_exponent++;
+            }
+            size_t const length = write_scientific(buffer, negative, candidate, candidate_n, candidate_exponent);
+            if(candidate_scaled > low + margin && candidate_scaled < high - margin) {
+                return length;
+            }
+            locale_t const previous = use_c_locale();
+            double const parsed = strtod(buffer, NULL);
+            uselocale(previous);
+            if(parsed == value) {
+                return length;
+            }
+        }
+    }
+    locale_t const previous = use_c_locale();
+    size_t const length = (size_t)snprintf(buffer, FORMAT_DOUBLE_MAX, "%.16E", value);
+    uselocale(previous);
+    return length;
+}
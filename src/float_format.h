@@ -0,0 +1,33 @@
+/*
+ Copyright (c) 2015 Ricardo Iván Vieitez Parra
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+
+/* Shortest round-trip text for doubles.
+ *
+ * format_double() writes the shortest decimal (at most 17 significant digits,
+ * in scientific notation) that strtod() reads back as exactly the same
+ * double, and returns its length. buffer must hold FORMAT_DOUBLE_MAX bytes;
+ * the output is NUL terminated and always uses '.', whatever the locale. */
+
+#define FORMAT_DOUBLE_MAX 32
+
+size_t format_double(double value, char* buffer);
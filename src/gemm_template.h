@@ -0,0 +1,314 @@
+/*
+ Copyright (c) 2015 Ricardo Iván Vieitez Parra
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+/* Packed, cache-blocked matrix multiplication (C = A * B).
+ *
+ * This file is a template: matrix.c includes it once per element type after
+ * defining GEMM_T (the element type), GEMM_SUFFIX (appended to every name) and
+ * GEMM_MR / GEMM_NR (register block of the portable micro-kernel).
+ *
+ * A and B are addressed through a row stride and a column stride, so the
+ * packing routines are the only place that cares about the operand layout.
+ * C is always a contiguous row-major block with leading dimension ldc.
+ *
+ * Requires thread_pool.h for gemm_parallel(), and GEMM_NAIVE_LIMIT and
+ * MATRIX_ELEMENT() for gemm_convert(), which is only generated if
+ * GEMM_CONVERT is defined. */
+
+#define GEMM_CONCAT2(a, b) a##_##b
+#define GEMM_CONCAT(a, b) GEMM_CONCAT2(a, b)
+#define GEMM_NAME(name) GEMM_CONCAT(name, GEMM_SUFFIX)
+
+#ifndef GEMM_MC
+#define GEMM_MC 96
+#define GEMM_KC 256
+#define GEMM_NC 2048
+/* Inner-dimension slice used when C is too small to be split into tiles */
+#define GEMM_KSPLIT 16384
+#endif
+
+struct GEMM_NAME(gemm_kernel) {
+    char const* name;
+    size_t mr;
+    size_t nr;
+    void (*f)(size_t kc, GEMM_T const* a, GEMM_T const* b, GEMM_T* c, size_t ldc, size_t m, size_t n);
+};
+
+/* Copy an mc × kc block of A into mr-row panels, each stored k-major and
+ * padded with zeros so the micro-kernel never has to check bounds. */
+static void GEMM_NAME(gemm_pack_a)(size_t const mc, size_t const kc, GEMM_T const * const A, size_t const rs, size_t const cs, size_t const mr, GEMM_T * packed)
+{
+    for(size_t i = 0; i < mc; i += mr) {
+        size_t const m = (mc - i < mr) ? mc - i : mr;
+        for(size_t p = 0; p < kc; p++) {
+            for(size_t r = 0; r < m; r++) {
+                *packed++ = A[(i + r) * rs + p * cs];
+            }
+            for(size_t r = m; r < mr; r++) {
+                *packed++ = 0;
+            }
+        }
+    }
+}
+
+/* Copy a kc × nc block of B into nr-column panels, each stored k-major */
+static void GEMM_NAME(gemm_pack_b)(size_t const kc, size_t const nc, GEMM_T const * const B, size_t const rs, size_t const cs, size_t const nr, GEMM_T * packed)
+{
+    for(size_t j = 0; j < nc; j += nr) {
+        size_t const n = (nc - j < nr) ? nc - j : nr;
+        for(size_t p = 0; p < kc; p++) {
+            for(size_t c = 0; c < n; c++) {
+                *packed++ = B[p * rs + (j + c) * cs];
+            }
+            for(size_t c = n; c < nr; c++) {
+                *packed++ = 0;
+            }
+        }
+    }
+}
+
+/* Portable register-blocked micro-kernel: C[0:m, 0:n] += a * b */
+static void GEMM_NAME(gemm_micro_kernel)(size_t const kc, GEMM_T const * a, GEMM_T const * b, GEMM_T * const c, size_t const ldc, size_t const m, size_t const n)
+{
+    GEMM_T acc[GEMM_MR][GEMM_NR];
+    for(size_t i = 0; i < GEMM_MR; i++) {
+        for(size_t j = 0; j < GEMM_NR; j++) {
+            acc[i][j] = 0;
+        }
+    }
+    for(size_t p = 0; p < kc; p++) {
+        for(size_t i = 0; i < GEMM_MR; i++) {
+            GEMM_T const ai = a[i];
+            for(size_t j = 0; j < GEMM_NR; j++) {
+                acc[i][j] += ai * b[j];
+            }
+        }
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+    for(size_t i = 0; i < m; i++) {
+        for(size_t j = 0; j < n; j++) {
+            c[i * ldc + j] += acc[i][j];
+        }
+    }
+}
+
+static struct GEMM_NAME(gemm_kernel) const GEMM_NAME(gemm_portable_kernel) = {
+    "portable",
+    GEMM_MR,
+    GEMM_NR,
+    GEMM_NAME(gemm_micro_kernel)
+};
+
+/* Reference i-j-k product, used for small operands where packing does not pay off */
+static void GEMM_NAME(gemm_naive)(size_t const m, size_t const n, size_t const k, GEMM_T const * const A, size_t const rsa, size_t const csa, GEMM_T const * const B, size_t const rsb, size_t const csb, GEMM_T * const C, size_t const ldc)
+{
+    for(size_t i = 0; i < m; i++) {
+        for(size_t j = 0; j < n; j++) {
+            GEMM_T sum = 0;
+            for(size_t p = 0; p < k; p++) {
+                sum += A[i * rsa + p * csa] * B[p * rsb + j * csb];
+            }
+            C[i * ldc + j] = sum;
+        }
+    }
+}
+
+/* Returns 0 on success and 1 if the packing buffers could not be allocated */
+static char GEMM_NAME(gemm_blocked)(size_t const m, size_t const n, size_t const k, GEMM_T const * const A, size_t const rsa, size_t const csa, GEMM_T const * const B, size_t const rsb, size_t const csb, GEMM_T * const C, size_t const ldc, struct GEMM_NAME(gemm_kernel) const * const kernel)
+{
+    size_t const mr = kernel->mr, nr = kernel->nr;
+    size_t const mc_max = ((GEMM_MC + mr - 1) / mr) * mr;
+    size_t const nc_max = ((GEMM_NC + nr - 1) / nr) * nr;
+    size_t const kc_max = (k < GEMM_KC) ? k : GEMM_KC;
+    GEMM_T * const packed_a = malloc(sizeof(GEMM_T) * (((m < mc_max ? m : mc_max) + mr - 1) / mr) * mr * kc_max);
+    GEMM_T * const packed_b = malloc(sizeof(GEMM_T) * (((n < nc_max ? n : nc_max) + nr - 1) / nr) * nr * kc_max);
+    if(packed_a == NULL || packed_b == NULL) {
+        free(packed_a);
+        free(packed_b);
+        return 1;
+    }
+    for(size_t i = 0; i < m; i++) {
+        for(size_t j = 0; j < n; j++) {
+            C[i * ldc + j] = 0;
+        }
+    }
+    for(size_t jc = 0; jc < n; jc += nc_max) {
+        size_t const nc = (n - jc < nc_max) ? n - jc : nc_max;
+        for(size_t pc = 0; pc < k; pc += GEMM_KC) {
+            size_t const kc = (k - pc < GEMM_KC) ? k - pc : GEMM_KC;
+            GEMM_NAME(gemm_pack_b)(kc, nc, B + pc * rsb + jc * csb, rsb, csb, nr, packed_b);
+            for(size_t ic = 0; ic < m; ic += mc_max) {
+                size_t const mc = (m - ic < mc_max) ? m - ic : mc_max;
+                GEMM_NAME(gemm_pack_a)(mc, kc, A + ic * rsa + pc * csa, rsa, csa, mr, packed_a);
+                for(size_t jr = 0; jr < nc; jr += nr) {
+                    for(size_t ir = 0; ir < mc; ir += mr) {
+                        kernel->f(kc, packed_a + ir * kc, packed_b + jr * kc, C + (ic + ir) * ldc + jc + jr, ldc, (mc - ir < mr) ? mc - ir : mr, (nc - jr < nr) ? nc - jr : nr);
+                    }
+                }
+            }
+        }
+    }
+    free(packed_a);
+    free(packed_b);
+    return 0;
+}
+
+struct GEMM_NAME(gemm_job) {
+    size_t m;
+    size_t n;
+    size_t k;
+    GEMM_T const* A;
+    size_t rsa;
+    size_t csa;
+    GEMM_T const* B;
+    size_t rsb;
+    size_t csb;
+    GEMM_T* C;
+    size_t ldc;
+    struct GEMM_NAME(gemm_kernel) const* kernel;
+    size_t tile_cols;
+    /* One status per task, so that no two threads write the same byte */
+    char* failed;
+};
+
+/* One task per GEMM_MC × GEMM_NC tile of C */
+static void GEMM_NAME(gemm_tile_task)(size_t const begin, size_t const end, void * const arg)
+{
+    struct GEMM_NAME(gemm_job) const * const job = arg;
+    for(size_t t = begin; t != end; t++) {
+        size_t const i = (t / job->tile_cols) * GEMM_MC, j = (t % job->tile_cols) * GEMM_NC;
+        size_t const m = (job->m - i < GEMM_MC) ? job->m - i : GEMM_MC;
+        size_t const n = (job->n - j < GEMM_NC) ? job->n - j : GEMM_NC;
+        job->failed[t] = GEMM_NAME(gemm_blocked)(m, n, job->k, job->A + i * job->rsa, job->rsa, job->csa, job->B + j * job->csb, job->rsb, job->csb, job->C + i * job->ldc + j, job->ldc, job->kernel);
+    }
+}
+
+/* One task per GEMM_KSPLIT slice of the inner dimension, each into its own
+ * m × n partial product (job->C) */
+static void GEMM_NAME(gemm_ksplit_task)(size_t const begin, size_t const end, void * const arg)
+{
+    struct GEMM_NAME(gemm_job) const * const job = arg;
+    for(size_t t = begin; t != end; t++) {
+        size_t const p = t * GEMM_KSPLIT;
+        size_t const k = (job->k - p < GEMM_KSPLIT) ? job->k - p : GEMM_KSPLIT;
+        job->failed[t] = GEMM_NAME(gemm_blocked)(job->m, job->n, k, job->A + p * job->csa, job->rsa, job->csa, job->B + p * job->rsb, job->rsb, job->csb, job->C + t * job->m * job->n, job->n, job->kernel);
+    }
+}
+
+/* Multithreaded gemm_blocked(). Large outputs are split into tiles; outputs
+ * that fit in a single tile but have a long inner dimension (V_T * V) are
+ * split along k and the partial products summed in order. The partitioning
+ * never depends on the number of threads, so neither does the result. */
+static char GEMM_NAME(gemm_parallel)(size_t const m, size_t const n, size_t const k, GEMM_T const * const A, size_t const rsa, size_t const csa, GEMM_T const * const B, size_t const rsb, size_t const csb, GEMM_T * const C, size_t const ldc, struct GEMM_NAME(gemm_kernel) const * const kernel)
+{
+    size_t const tile_rows = (m + GEMM_MC - 1) / GEMM_MC, tile_cols = (n + GEMM_NC - 1) / GEMM_NC;
+    size_t const k_slices = (k + GEMM_KSPLIT - 1) / GEMM_KSPLIT;
+    char const ksplit = tile_rows * tile_cols == 1 && k_slices > 1;
+    size_t const n_tasks = ksplit ? k_slices : tile_rows * tile_cols;
+    if(n_tasks == 1) {
+        return GEMM_NAME(gemm_blocked)(m, n, k, A, rsa, csa, B, rsb, csb, C, ldc, kernel);
+    }
+    struct GEMM_NAME(gemm_job) job = {
+        m, n, k,
+        A, rsa, csa,
+        B, rsb, csb,
+        C, ldc,
+        kernel,
+        tile_cols,
+        calloc(n_tasks, sizeof(char))
+    };
+    if(job.failed == NULL) {
+        return 1;
+    }
+    if(ksplit) {
+        job.C = malloc(sizeof(GEMM_T) * m * n * k_slices);
+        if(job.C == NULL) {
+            free(job.failed);
+            return 1;
+        }
+    }
+    parallel_for(n_tasks, 1L, ksplit ? GEMM_NAME(gemm_ksplit_task) : GEMM_NAME(gemm_tile_task), &job);
+    char failed = 0;
+    for(size_t t = 0; t != n_tasks; t++) {
+        failed |= job.failed[t];
+    }
+    if(ksplit) {
+        if(!failed) {
+            for(size_t i = 0; i < m; i++) {
+                for(size_t j = 0; j < n; j++) {
+                    GEMM_T sum = 0;
+                    for(size_t t = 0; t != k_slices; t++) {
+                        sum += job.C[t * m * n + i * n + j];
+                    }
+                    C[i * ldc + j] = sum;
+                }
+            }
+        }
+        free(job.C);
+    }
+    free(job.failed);
+    return failed;
+}
+
+#ifdef GEMM_CONVERT
+/* result = A * B computed in GEMM_T: the long double operands (any strides)
+ * are narrowed into contiguous buffers and the product widened back */
+static char GEMM_NAME(gemm_convert)(struct matrix const * const A, struct matrix const * const B, struct matrix * const result, struct GEMM_NAME(gemm_kernel) const * const kernel)
+{
+    size_t const m = A->rows, n = B->cols, k = A->cols;
+    GEMM_T * const a = malloc(sizeof(GEMM_T) * m * k);
+    GEMM_T * const b = malloc(sizeof(GEMM_T) * k * n);
+    GEMM_T * const c = malloc(sizeof(GEMM_T) * m * n);
+    char failed = a == NULL || b == NULL || c == NULL;
+    if(!failed) {
+        for(size_t i = 0; i < m; i++) {
+            for(size_t p = 0; p < k; p++) {
+                a[i * k + p] = (GEMM_T)MATRIX_ELEMENT(A, i, p);
+            }
+        }
+        for(size_t p = 0; p < k; p++) {
+            for(size_t j = 0; j < n; j++) {
+                b[p * n + j] = (GEMM_T)MATRIX_ELEMENT(B, p, j);
+            }
+        }
+        if(n == 1L || m * n * k < GEMM_NAIVE_LIMIT) {
+            GEMM_NAME(gemm_naive)(m, n, k, a, k, 1L, b, n, 1L, c, n);
+        } else {
+            failed = GEMM_NAME(gemm_parallel)(m, n, k, a, k, 1L, b, n, 1L, c, n, kernel);
+        }
+    }
+    if(!failed) {
+        for(size_t i = 0; i < m * n; i++) {
+            result->elements[i] = c[i];
+        }
+    }
+    free(a);
+    free(b);
+    free(c);
+    return failed;
+}
+#endif
+
+#undef GEMM_NAME
+#undef GEMM_CONCAT
+#undef GEMM_CONCAT2
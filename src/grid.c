@@ -0,0 +1,159 @@
+/*
+ Copyright (c) 2015 Ricardo Iván Vieitez Parra
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <math.h>
+#include "grid.h"
+
+#ifndef M_PI
+#define M_PI 3.1415926535897932384626433832795028841971L
+#endif
+
+/* Taylor coefficients (-1)**k / (2k + 1)! of sin */
+static long double const sine_coefficients[12] = {
+    1.0L / 1.0L,
+    -1.0L / 6.0L,
+    1.0L / 120.0L,
+    -1.0L / 5040.0L,
+    1.0L / 362880.0L,
+    -1.0L / 39916800.0L,
+    1.0L / 6227020800.0L,
+    -1.0L / 1307674368000.0L,
+    1.0L / 355687428096000.0L,
+    -1.0L / 121645100408832000.0L,
+    1.0L / 51090942171709440000.0L,
+    -1.0L / 25852016738884976640000.0L
+};
+
+/* sin²(pi t / 2) = (1 + sin(pi (t - 1/2))) / 2. Only |pi (t - 1/2)| <= pi / 2
+ * is needed, where the degree 23 polynomial is within 1E-20 of sin */
+static inline long double raised_cosine_kernel(long double const t)
+{
+    long double const u = M_PI * (t - 0.5L), u2 = u * u;
+    long double s = sine_coefficients[11];
+    for(size_t k = 11; k != 0; k--) {
+        s = s * u2 + sine_coefficients[k - 1];
+    }
+    return 0.5L + 0.5L * u * s;
+}
+
+struct grid_evaluator* create_grid_evaluator(enum grid_kernel const kernel, long double const start, long double const end, long double const sampling_interval, long double const * const samples, size_t const n_samples)
+{
+    if(n_samples < 2) {
+        return NULL;
+    }
+    struct grid_evaluator * const grid = malloc(sizeof(struct grid_evaluator));
+    if(grid == NULL) {
+        return NULL;
+    }
+    grid->cells = n_samples - 1;
+    grid->values = malloc(sizeof(long double) * grid->cells * 2);
+    if(grid->values == NULL) {
+        free(grid);
+        return NULL;
+    }
+    grid->deltas = grid->values + grid->cells;
+    grid->kernel = kernel;
+    grid->start = start;
+    grid->end = end;
+    grid->inverse_interval = 1.0L / sampling_interval;
+    for(size_t i = 0; i != grid->cells; i++) {
+        grid->values[i] = samples[i];
+        grid->deltas[i] = samples[i + 1] - samples[i];
+    }
+    return grid;
+}
+
+void destroy_grid_evaluator(struct grid_evaluator * const grid)
+{
+    free(grid->values);
+    free(grid);
+}
+
+/* x already known to be in range. Past the last sample, which can miss end
+ * by rounding, the last cell is used */
+static inline long double grid_evaluate(struct grid_evaluator const * const grid, long double const x)
+{
+    long double const s = (x - grid->start) * grid->inverse_interval;
+    size_t cell = (size_t)s;
+    if(cell >= grid->cells) {
+        cell = grid->cells - 1;
+    }
+    long double const t = s - (long double)cell;
+    if(grid->kernel == GRID_KERNEL_RAISED_COSINE) {
+        return grid->values[cell] + grid->deltas[cell] * raised_cosine_kernel(t);
+    }
+    return grid->values[cell] + grid->deltas[cell] * t;
+}
+
+long double grid_evaluator_value(struct grid_evaluator const * const grid, long double const x)
+{
+    if(!(x >= grid->start && x <= grid->end)) {
+        return NAN;
+    }
+    return grid_evaluate(grid, x);
+}
+
+static void grid_evaluator_values_unsorted(struct grid_evaluator const * const grid, long double const * const x, long double * const y, size_t const n)
+{
+    for(size_t i = 0; i != n; i++) {
+        y[i] = grid_evaluator_value(grid, x[i]);
+    }
+}
+
+void grid_evaluator_values(struct grid_evaluator const * const grid, long double const * const x, long double * const y, size_t const n)
+{
+    for(size_t i = 1; i < n; i++) {
+        if(!(x[i - 1] <= x[i])) {
+            grid_evaluator_values_unsorted(grid, x, y, n);
+            return;
+        }
+    }
+    grid_evaluator_values_sorted(grid, x, y, n);
+}
+
+void grid_evaluator_values_sorted(struct grid_evaluator const * const grid, long double const * const x, long double * const y, size_t const n)
+{
+    if(n == 0) {
+        return;
+    }
+    if(!(x[0] >= grid->start && x[n - 1] <= grid->end)) {
+        grid_evaluator_values_unsorted(grid, x, y, n);
+        return;
+    }
+    if(grid->kernel == GRID_KERNEL_RAISED_COSINE) {
+        for(size_t i = 0; i != n; i++) {
+            long double const s = (x[i] - grid->start) * grid->inverse_interval;
+            size_t const cell = ((size_t)s < grid->cells) ? (size_t)s : grid->cells - 1;
+            y[i] = grid->values[cell] + grid->deltas[cell] * raised_cosine_kernel(s - (long double)cell);
+        }
+    } else {
+        for(size_t i = 0; i != n; i++) {
+            long double const s = (x[i] - grid->start) * grid->inverse_interval;
+            size_t const cell = ((size_t)s < grid->cells) ? (size_t)s : grid->cells - 1;
+            y[i] = grid->values[cell] + grid->deltas[cell] * (s - (long double)cell);
+        }
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ Copyright (c) 2015 Ricardo Iván Vieitez Parra
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+
+/* Evaluator for interpolants on a uniform grid.
+ *
+ * Cell i spans [start + i * interval, start + (i + 1) * interval] and holds
+ * the sample at its left end and the difference to the next one, so a query
+ * is one multiply by the reciprocal interval, a truncation and
+ * y_i + delta_i * kernel(t) with t in [0, 1]: t itself for piecewise linear,
+ * sin²(pi t / 2) for raised cosine. */
+
+enum grid_kernel {
+    GRID_KERNEL_LINEAR,
+    GRID_KERNEL_RAISED_COSINE
+};
+
+struct grid_evaluator {
+    enum grid_kernel kernel;
+    long double start;
+    long double end;
+    long double inverse_interval;
+    size_t cells;
+    long double* values;
+    long double* deltas;
+};
+
+/* n_samples >= 2 samples, the first at start, covering [start, end]. end is
+ * taken as given rather than recomputed from the samples, so that a query at
+ * the interpolation's own end is always in range */
+struct grid_evaluator* create_grid_evaluator(enum grid_kernel kernel, long double start, long double end, long double sampling_interval, long double const* samples, size_t n_samples);
+void destroy_grid_evaluator(struct grid_evaluator*);
+/* NAN outside [start, end] */
+long double grid_evaluator_value(struct grid_evaluator const*, long double x);
+/* Takes the sorted path below when x turns out to be in ascending order */
+void grid_evaluator_values(struct grid_evaluator const*, long double const* x, long double* y, size_t n);
+/* x must be in ascending order; the range is only checked at both ends */
+void grid_evaluator_values_sorted(struct grid_evaluator const*, long double const* x, long double* y, size_t n);
@@ -0,0 +1,185 @@
+/*
+ Copyright (c) 2015 Ricardo Iván Vieitez Parra
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include "utilities.h"
+#include "thread_pool.h"
+#include "instrument.h"
+
+/* Padded so that slots of different threads never share a cache line */
+struct instrument_slot {
+    struct instrument_counters counters;
+    char padding[64];
+};
+
+static unsigned long long nanoseconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+static void reset_counters(struct instrument_counters * const counters)
+{
+    memset(counters, 0, sizeof(struct instrument_counters));
+    counters->min_nanoseconds = ~0ULL;
+}
+
+/* Batches are recorded as calls evaluations taking the average time each */
+static void record(struct instrument const * const instrument, unsigned long const calls, unsigned long long const elapsed)
+{
+    size_t index = thread_pool_thread_index();
+    if(index >= instrument->n_slots) {
+        index = 0;
+    }
+    struct instrument_counters * const counters = &instrument->slots[index].counters;
+    unsigned long long const each = elapsed / calls;
+    size_t bin = 0;
+    while(bin != INSTRUMENT_HISTOGRAM_BINS - 1 && (each >> (bin + 1)) != 0) {
+        bin++;
+    }
+    counters->calls += calls;
+    counters->nanoseconds += elapsed;
+    if(each < counters->min_nanoseconds) {
+        counters->min_nanoseconds = each;
+    }
+    if(each > counters->max_nanoseconds) {
+        counters->max_nanoseconds = each;
+    }
+    counters->histogram[bin] += calls;
+}
+
+static long double instrumented_f(long double const x, void const * const arg)
+{
+    struct instrument const * const instrument = arg;
+    unsigned long long const start = nanoseconds();
+    long double const y = instrument->wrapped->f(x, instrument->wrapped->arg);
+    record(instrument, 1, nanoseconds() - start);
+    return y;
+}
+
+static void instrumented_f_batch(long double const * const x, long double * const y, size_t const n, void const * const arg)
+{
+    struct instrument const * const instrument = arg;
+    if(n == 0) {
+        return;
+    }
+    unsigned long long const start = nanoseconds();
+    function_values(instrument->wrapped, x, y, n);
+    record(instrument, n, nanoseconds() - start);
+}
+
+struct instrument* create_instrument(struct function const * const function)
+{
+    struct instrument * const instrument = malloc(sizeof(struct instrument));
+    if(instrument == NULL) {
+        fprintf(stderr, "create_instrument(): Unable to allocate memory.\n");
+        return NULL;
+    }
+    instrument->n_slots = thread_pool_threads();
+    instrument->slots = malloc(sizeof(struct instrument_slot) * instrument->n_slots);
+    if(instrument->slots == NULL) {
+        fprintf(stderr, "create_instrument(): Unable to allocate memory.\n");
+        free(instrument);
+        return NULL;
+    }
+    instrument->wrapped = function;
+    instrument->function.name = function->name;
+    instrument->function.f = instrumented_f;
+    instrument->function.arg = instrument;
+    instrument->function.f_batch = instrumented_f_batch;
+    instrument_reset(instrument);
+    return instrument;
+}
+
+void destroy_instrument(struct instrument * const instrument)
+{
+    if(instrument == NULL) {
+        return;
+    }
+    free(instrument->slots);
+    free(instrument);
+}
+
+/* Must not be called while the function is being evaluated */
+void instrument_reset(struct instrument * const instrument)
+{
+    for(size_t i = 0; i != instrument->n_slots; i++) {
+        reset_counters(&instrument->slots[i].counters);
+    }
+}
+
+void instrument_counters(struct instrument const * const instrument, struct instrument_counters * const counters)
+{
+    reset_counters(counters);
+    for(size_t i = 0; i != instrument->n_slots; i++) {
+        struct instrument_counters const * const slot = &instrument->slots[i].counters;
+        counters->calls += slot->calls;
+        counters->nanoseconds += slot->nanoseconds;
+        if(slot->min_nanoseconds < counters->min_nanoseconds) {
+            counters->min_nanoseconds = slot->min_nanoseconds;
+        }
+        if(slot->max_nanoseconds > counters->max_nanoseconds) {
+            counters->max_nanoseconds = slot->max_nanoseconds;
+        }
+        for(size_t j = 0; j != INSTRUMENT_HISTOGRAM_BINS; j++) {
+            counters->histogram[j] += slot->histogram[j];
+        }
+    }
+}
+
+void instrument_result(struct instrument const * const instrument, struct result * const result)
+{
+    struct instrument_counters counters;
+    instrument_counters(instrument, &counters);
+    result->evaluations += counters.calls;
+    result->time += (long double)counters.nanoseconds * 1E-9L;
+}
+
+void instrument_report(struct instrument const * const instrument, FILE * const file)
+{
+    struct instrument_counters counters;
+    instrument_counters(instrument, &counters);
+    fprintf(file, "%s: %lu evaluations", instrument->function.name, counters.calls);
+    if(counters.calls == 0) {
+        fprintf(file, "\n");
+        return;
+    }
+    fprintf(file, ", %.1f ns each (min %llu, max %llu)\n", (double)counters.nanoseconds / (double)counters.calls, counters.min_nanoseconds, counters.max_nanoseconds);
+    for(size_t i = 0; i != INSTRUMENT_HISTOGRAM_BINS; i++) {
+        if(counters.histogram[i] != 0) {
+            if(i == INSTRUMENT_HISTOGRAM_BINS - 1) {
+                fprintf(file, "  [%llu, inf) ns: %lu\n", 1ULL << i, counters.histogram[i]);
+            } else {
+                fprintf(file, "  [%llu, %llu) ns: %lu\n", (i == 0) ? 0ULL : 1ULL << i, 1ULL << (i + 1), counters.histogram[i]);
+            }
+        }
+    }
+}
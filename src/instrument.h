@@ -0,0 +1,62 @@
+/*
+ Copyright (c) 2015 Ricardo Iván Vieitez Parra
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+
+
+/* Opt-in instrumentation for struct function.
+ *
+ * An instrument wraps a function and is used in its place: instrument->function
+ * forwards every call (and batch) to the wrapped function, counting the points
+ * evaluated and the time they took. Counters are kept per thread_pool thread,
+ * each only written by its own thread, and summed by instrument_counters().
+ * The number of threads must not change while an instrument exists.
+ *
+ * Include after utilities.h. */
+
+/* Bin i counts evaluations taking [2^i, 2^(i + 1)) ns, the last one also
+ * anything longer */
+#define INSTRUMENT_HISTOGRAM_BINS 32
+
+struct instrument_counters {
+    unsigned long calls;
+    unsigned long long nanoseconds;
+    unsigned long long min_nanoseconds;
+    unsigned long long max_nanoseconds;
+    unsigned long histogram[INSTRUMENT_HISTOGRAM_BINS];
+};
+
+struct instrument_slot;
+
+struct instrument {
+    struct function function;
+    struct function const* wrapped;
+    size_t n_slots;
+    struct instrument_slot* slots;
+};
+
+struct instrument* create_instrument(struct function const*);
+void destroy_instrument(struct instrument*);
+void instrument_reset(struct instrument*);
+void instrument_counters(struct instrument const*, struct instrument_counters*);
+/* Adds the calls and time counted so far to result->evaluations and result->time */
+void instrument_result(struct instrument const*, struct result*);
+void instrument_report(struct instrument const*, FILE*);
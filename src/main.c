@@ -20,17 +20,38 @@
  THE SOFTWARE.
 */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <locale.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
 #include <math.h>
 #include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 #include "utilities.h"
+#include "instrument.h"
+#include "precision.h"
+#include "thread_pool.h"
+#include "task_graph.h"
 #include "project1.h"
 
 #define TOLERANCE 1E-7L
 #define TOLERANCE_3 1.0L/35184372088832.0L
 #define EXPORT_POINTS 524288L
+#define PLOT_POINTS 4096L
+#define LEAST_SQUARES_POINTS 524288L
+#define ERROR_TOLERANCE 1E-6L
+/* Steps find_roots() scans the visual inspection interval in */
+#define ROOT_SCAN_STEPS 1024L
+/* Values of k per square_root_values() call in the bonus problem sweep */
+#define SQUARE_ROOT_BATCH 262144L
+/* Most orders --orders takes */
+#define MAX_ORDERS 16
+/* Most interpolations a stage makes */
+#define MAX_INTERPOLATIONS (2 * MAX_ORDERS)
 
 /* The function we are interested in for this project (1-3) */
 static long double f(long double x)
@@ -86,6 +107,11 @@ static long double h(long double x)
     return 1.0L / (powl(x, 2.0L) + 1.0L);
 }
 
+static long double h_derivative(long double x)
+{
+    return -2.0L * x / powl(powl(x, 2.0L) + 1.0L, 2.0L);
+}
+
 struct function const study_functions[] = {
     {
         "e**(-x/5)/sin(x)",
@@ -157,201 +183,767 @@ struct function const interpolation_function = {
     NULL
 };
 
-int main(int argc, char** argv)
+struct function const interpolation_function_derivative = {
+    "-2x/(1+x**2)**2",
+    (long double(*)(long double, void const*))h_derivative,
+    NULL
+};
+
+/* Everything a stage can be told from the command line */
+struct settings {
+    /* Interval the interpolation stages work on */
+    long double start;
+    long double end;
+    /* Interval plotted and scanned for roots */
+    long double roots_start;
+    long double roots_end;
+    /* No orders means each stage's own */
+    size_t n_orders;
+    unsigned long orders[MAX_ORDERS];
+    struct gnuplot_options export_options;
+    unsigned long export_points;
+};
+
+struct interpolation_family {
+    /* Base name of the exported files, NULL to not export */
+    char const* base;
+    /* printf() format taking the name of the interpolated function */
+    char const* title;
+    long double (*value)(long double, struct interpolation const*);
+    void (*values)(long double const*, long double*, size_t, struct interpolation const*);
+    long double (*error)(struct interpolation const*);
+    struct result (*error_adaptive)(struct interpolation const*, long double);
+    char print_coefficients;
+    unsigned long const* default_orders;
+    size_t n_default_orders;
+    /* fit() makes interpolations_per_order * n + extra_interpolations
+     * interpolations for n orders, and a label (or NULL) for each */
+    size_t interpolations_per_order;
+    size_t extra_interpolations;
+    void (*fit)(struct settings const*, unsigned long const*, size_t, struct interpolation const**, char const**);
+};
+
+/* The interpolations of one stage, shared by its fit, export and error tasks */
+struct interpolation_stage {
+    struct interpolation_family const* family;
+    size_t n;
+    struct interpolation const* interpolations[MAX_INTERPOLATIONS];
+    char const* labels[MAX_INTERPOLATIONS];
+    struct function functions[MAX_INTERPOLATIONS];
+};
+
+/* Number of orders a stage uses: the ones given, or its defaults */
+static size_t stage_orders(struct settings const * const settings, struct interpolation_family const * const family, unsigned long const ** const orders)
 {
-    setlocale(LC_ALL, "");
+    if(settings->n_orders == 0) {
+        *orders = family->default_orders;
+        return family->n_default_orders;
+    }
+    *orders = settings->orders;
+    return settings->n_orders;
+}
 
-    gnuplot("1_visual_inspection", 1, 0.0L, 10.0L, EXPORT_POINTS, &study_functions[0]);
+static size_t stage_interpolations(struct settings const * const settings, struct interpolation_family const * const family)
+{
+    unsigned long const* orders;
+    return family->interpolations_per_order * stage_orders(settings, family, &orders) + family->extra_interpolations;
+}
 
-    struct result const bisection_result[] = {
-        bisection_method(&study_functions[0], 0.5L, 1.5L, TOLERANCE),
-        bisection_method(&study_functions[0], 2.0L, 3.0L, TOLERANCE),
-        bisection_method(&study_functions[0], 6.0L, 7.0L, TOLERANCE),
-        bisection_method(&study_functions[0], 9.0L, 10.0L, TOLERANCE),
-    };
+static int visual_inspection_stage(struct settings const * const settings, FILE * const out)
+{
+    gnuplot_with_options(&settings->export_options, "1_visual_inspection", 1, settings->roots_start, settings->roots_end, settings->export_points, &study_functions[0]);
+    return 0;
+}
 
-    printf("Bisection Method: %s\n", study_functions[0].name);
+static int roots_stage(struct settings const * const settings, FILE * const out)
+{
+    struct instrument * const instrumented = create_instrument(&study_functions[0]);
+    struct instrument * const instrumented_derivative = create_instrument(&study_function_derivatives[0]);
+    if(instrumented == NULL || instrumented_derivative == NULL) {
+        destroy_instrument(instrumented);
+        destroy_instrument(instrumented_derivative);
+        return 1;
+    }
+
+    long double const bisection_lower[] = {0.5L, 2.0L, 6.0L, 9.0L};
+    long double const bisection_upper[] = {1.5L, 3.0L, 7.0L, 10.0L};
+    struct result * const bisection_result = multi_bisection_method(&instrumented->function, bisection_lower, bisection_upper, 4, TOLERANCE);
+    if(bisection_result == NULL) {
+        destroy_instrument(instrumented);
+        destroy_instrument(instrumented_derivative);
+        return 1;
+    }
+
+    fprintf(out, "Bisection Method: %s\n", study_functions[0].name);
     for(int i = 0; i != 4; i++) {
-        report_result(&bisection_result[i]);
+        fprint_result(out, &bisection_result[i]);
     }
+    instrument_report(instrumented, out);
 
-    struct result const newtons_result[] = {
-        newtons_method(&study_functions[0], &study_function_derivatives[0], 1.0L, bisection_result[0].iterations * 4, TOLERANCE),
-        newtons_method(&study_functions[0], &study_function_derivatives[0], 2.5L, bisection_result[1].iterations * 4, TOLERANCE),
-        newtons_method(&study_functions[0], &study_function_derivatives[0], 6.5L, bisection_result[2].iterations * 4, TOLERANCE),
-        newtons_method(&study_functions[0], &study_function_derivatives[0], 9.9L, bisection_result[3].iterations * 4, TOLERANCE)
-    };
+    struct result bracketing_result[3][4];
+    for(int i = 0; i != 4; i++) {
+        for(int j = 0; j != 3; j++) {
+            instrument_reset(instrumented);
+            switch(j) {
+                case 0:
+                    bracketing_result[j][i] = brent_method(&instrumented->function, bisection_lower[i], bisection_upper[i], TOLERANCE);
+                    break;
+                case 1:
+                    bracketing_result[j][i] = illinois_method(&instrumented->function, bisection_lower[i], bisection_upper[i], TOLERANCE);
+                    break;
+                default:
+                    bracketing_result[j][i] = secant_method(&instrumented->function, bisection_lower[i], bisection_upper[i], bisection_result[i].iterations * 4, TOLERANCE);
+                    break;
+            }
+            instrument_result(instrumented, &bracketing_result[j][i]);
+        }
+    }
+    char const * const bracketing_names[] = {"Brent's Method", "Illinois Method", "Secant Method"};
+    for(int j = 0; j != 3; j++) {
+        fprintf(out, "%s: %s\n", bracketing_names[j], study_functions[0].name);
+        for(int i = 0; i != 4; i++) {
+            fprint_result(out, &bracketing_result[j][i]);
+        }
+    }
 
-    printf("Newton's Method: %s\n", study_functions[0].name);
+    size_t n_roots;
+    struct result * const roots = find_roots(&study_functions[0], NULL, settings->roots_start, settings->roots_end, ROOT_SCAN_STEPS, TOLERANCE, &n_roots);
+    fprintf(out, "Root isolation on [%Lg, %Lg]: %s (%lu roots)\n", settings->roots_start, settings->roots_end, study_functions[0].name, n_roots);
+    for(size_t i = 0; i != n_roots; i++) {
+        fprint_result(out, &roots[i]);
+    }
+    free(roots);
+
+    long double const newtons_start[] = {1.0L, 2.5L, 6.5L, 9.9L};
+    struct result newtons_result[4];
+    for(int i = 0; i != 4; i++) {
+        instrument_reset(instrumented);
+        instrument_reset(instrumented_derivative);
+        newtons_result[i] = newtons_method(&instrumented->function, &instrumented_derivative->function, newtons_start[i], bisection_result[i].iterations * 4, TOLERANCE);
+        instrument_result(instrumented, &newtons_result[i]);
+        instrument_result(instrumented_derivative, &newtons_result[i]);
+    }
+
+    fprintf(out, "Newton's Method: %s\n", study_functions[0].name);
     for(int i = 0; i != 4; i++) {
-        report_result(&newtons_result[i]);
+        fprint_result(out, &newtons_result[i]);
     }
+    destroy_instrument(instrumented);
+    destroy_instrument(instrumented_derivative);
+    free(bisection_result);
+    return 0;
+}
 
+static int multiple_root_stage(struct settings const * const settings, FILE * const out)
+{
     struct result const newtons_result_3 = newtons_method(&study_functions[1], &study_function_derivatives[1], 2.0L, 256, TOLERANCE_3);
-    printf("Newton's Method (part 3): %s\n", study_functions[1].name);
-    report_result(&newtons_result_3);
+    fprintf(out, "Newton's Method (part 3): %s\n", study_functions[1].name);
+    fprint_result(out, &newtons_result_3);
 
     struct result const altered_newtons_result_3 = altered_newtons_method(&study_functions[1], &study_function_derivatives[1], &study_function_secondderivatives[1], 2.0L, 256, TOLERANCE_3);
-    printf("Altered Newton's Method (part 3): %s\n", study_functions[1].name);
-    report_result(&altered_newtons_result_3);
+    fprintf(out, "Altered Newton's Method (part 3): %s\n", study_functions[1].name);
+    fprint_result(out, &altered_newtons_result_3);
+    return 0;
+}
 
-    struct interpolation const* lagrange[] = {
-        lagrange_interpolation(&interpolation_function, -5.0L, 5.0L, 5),
-        lagrange_interpolation(&interpolation_function, -5.0L, 5.0L, 10),
-        lagrange_interpolation(&interpolation_function, -5.0L, 5.0L, 20)
-    };
-    struct function const lagrange_functions[] = {
-        {
-            lagrange[0]->name,
-            (long double(*)(long double, void const*))polynomial_value,
-            lagrange[0]
-        },
-        {
-            lagrange[1]->name,
-            (long double(*)(long double, void const*))polynomial_value,
-            lagrange[1]
-        },
-        {
-            lagrange[2]->name,
-            (long double(*)(long double, void const*))polynomial_value,
-            lagrange[2]
+/* Bonus Problem 1 */
+static int square_root_stage(struct settings const * const settings, FILE * const out)
+{
+    /* k = 10 + j / 8192 up to 10000, a batch of square_root_values() at a time */
+    size_t const square_roots = (size_t)((10000.0L - 10.0L) * 8192.0L) + 1;
+    long double * const square_root_k = malloc(sizeof(long double) * SQUARE_ROOT_BATCH);
+    struct result * const square_root_results = malloc(sizeof(struct result) * SQUARE_ROOT_BATCH);
+    if(square_root_k == NULL || square_root_results == NULL) {
+        free(square_root_k);
+        free(square_root_results);
+        return 1;
+    }
+    unsigned long square_root_errors = 0;
+    for(size_t begin = 0; begin < square_roots; begin += SQUARE_ROOT_BATCH) {
+        size_t const n = (square_roots - begin < SQUARE_ROOT_BATCH) ? square_roots - begin : SQUARE_ROOT_BATCH;
+        for(size_t j = 0; j != n; j++) {
+            square_root_k[j] = 10.0L + (long double)(begin + j) / 8192.0L;
         }
-    };
-    gnuplot("lagrange", 4, -5.0L, 5.0L, EXPORT_POINTS, &interpolation_function, &lagrange_functions[0], &lagrange_functions[1], &lagrange_functions[2]);
-
-    printf("Lagrange interpolation coefficients for %s\n", interpolation_function.name);
-    for(int i = 0; i != 3; i++) {
-        for(ssize_t j = lagrange[i]->order; j >= 0; j--) {
-            printf("%.4LE x**%ld%s", fabsl(lagrange[i]->coefficients[j]), j, j == 0 ? "" : (lagrange[i]->coefficients[j - 1] < 0.0L ? " - " : " + "));
+        square_root_values(square_root_k, square_root_results, n);
+        for(size_t j = 0; j != n; j++) {
+            double long const real_sqrt = sqrtl(square_root_k[j]);
+            if(fabsl(square_root_results[j].value - real_sqrt) > square_root_results[j].error) {
+                square_root_errors++;
+                fprintf(out, "Error for square root of %Lf (%Lf ± %LE not %Lf) \n", square_root_k[j], square_root_results[j].value, square_root_results[j].error, real_sqrt);
+            }
         }
-        printf(" order: %ld, error: %.2LE\n", lagrange[i]->order, polynomial_error(lagrange[i]));
-        destroy_interpolation((struct interpolation*)lagrange[i]);
     }
+    free(square_root_k);
+    free(square_root_results);
+    if(square_root_errors == 0) {
+        fprintf(out, "Success for square root\n");
+    }
+    return 0;
+}
 
-    struct interpolation const* piecewise_linear[] = {
-        piecewise_linear_interpolation(&interpolation_function, -5.0L, 5.0L, 5),
-        piecewise_linear_interpolation(&interpolation_function, -5.0L, 5.0L, 10),
-        piecewise_linear_interpolation(&interpolation_function, -5.0L, 5.0L, 20)
+/* Bonus Problem 2 */
+static int adjusting_newton_stage(struct settings const * const settings, FILE * const out)
+{
+    struct result const bonus_newtons_result[] = {
+        newtons_method(&bonus_functions[0], &bonus_function_derivatives[0], 5.0L, 256, TOLERANCE),
+        newtons_method(&bonus_functions[1], &bonus_function_derivatives[1], 5.0L, 256, TOLERANCE)
     };
-    struct function const piecewise_linear_functions[] = {
-        {
-            piecewise_linear[0]->name,
-            (long double(*)(long double, void const*))piecewise_linear_value,
-            piecewise_linear[0]
-        },
-        {
-            piecewise_linear[1]->name,
-            (long double(*)(long double, void const*))piecewise_linear_value,
-            piecewise_linear[1]
-        },
-        {
-            piecewise_linear[2]->name,
-            (long double(*)(long double, void const*))piecewise_linear_value,
-            piecewise_linear[2]
-        }
+    struct result const adjusting_bonus_newtons_result[] = {
+        adjusting_newtons_method(&bonus_functions[0], &bonus_function_derivatives[0], 5.0L, 256, TOLERANCE),
+        adjusting_newtons_method(&bonus_functions[1], &bonus_function_derivatives[1], 5.0L, 256, TOLERANCE)
     };
-    gnuplot("piecewise_linear", 4, -5.0L, 5.0L, EXPORT_POINTS, &interpolation_function, &piecewise_linear_functions[0], &piecewise_linear_functions[1], &piecewise_linear_functions[2]);
 
-    printf("Piecewise linear interpolation coefficients for %s\n", interpolation_function.name);
-    for(int i = 0; i != 3; i++) {
-        printf(" order: %ld, error: %.2LE\n", piecewise_linear[i]->order, piecewise_linear_error(piecewise_linear[i]));
-        destroy_interpolation((struct interpolation*)piecewise_linear[i]);
+    fprintf(out, "Bonus Problem 2: Adjusting Newton's Method\n");
+    for(int i = 0; i != 2; i++) {
+        fprintf(out, "function %s:\n", bonus_functions[i].name);
+        fprint_result(out, &bonus_newtons_result[i]);
+        fprint_result(out, &adjusting_bonus_newtons_result[i]);
     }
+    return 0;
+}
 
-    struct interpolation const* raised_cosine[] = {
-        raised_cosine_interpolation(&interpolation_function, -5.0L, 5.0L, 5),
-        raised_cosine_interpolation(&interpolation_function, -5.0L, 5.0L, 10),
-        raised_cosine_interpolation(&interpolation_function, -5.0L, 5.0L, 20)
-    };
-    struct function const raised_cosine_functions[] = {
-        {
-            raised_cosine[0]->name,
-            (long double(*)(long double, void const*))raised_cosine_value,
-            raised_cosine[0]
-        },
-        {
-            raised_cosine[1]->name,
-            (long double(*)(long double, void const*))raised_cosine_value,
-            raised_cosine[1]
-        },
-        {
-            raised_cosine[2]->name,
-            (long double(*)(long double, void const*))raised_cosine_value,
-            raised_cosine[2]
+static unsigned long const default_orders[] = {5, 10, 20};
+static unsigned long const chebyshev_orders[] = {5, 10, 20, 40};
+
+static void lagrange_fit(struct settings const * const settings, unsigned long const * const orders, size_t const n, struct interpolation const ** const interpolations, char const ** const labels)
+{
+    for(size_t i = 0; i != n; i++) {
+        interpolations[i] = lagrange_interpolation(&interpolation_function, settings->start, settings->end, orders[i]);
+        labels[i] = NULL;
+    }
+}
+
+static void barycentric_fit(struct settings const * const settings, unsigned long const * const orders, size_t const n, struct interpolation const ** const interpolations, char const ** const labels)
+{
+    for(size_t i = 0; i != n; i++) {
+        interpolations[2 * i] = barycentric_lagrange_interpolation(&interpolation_function, settings->start, settings->end, orders[i], INTERPOLATION_NODES_UNIFORM);
+        labels[2 * i] = "uniform nodes";
+        interpolations[2 * i + 1] = barycentric_lagrange_interpolation(&interpolation_function, settings->start, settings->end, orders[i], INTERPOLATION_NODES_CHEBYSHEV);
+        labels[2 * i + 1] = "Chebyshev nodes";
+    }
+}
+
+static void chebyshev_fit(struct settings const * const settings, unsigned long const * const orders, size_t const n, struct interpolation const ** const interpolations, char const ** const labels)
+{
+    for(size_t i = 0; i != n; i++) {
+        interpolations[i] = chebyshev_interpolation(&interpolation_function, settings->start, settings->end, orders[i]);
+        labels[i] = NULL;
+    }
+}
+
+static void piecewise_linear_fit(struct settings const * const settings, unsigned long const * const orders, size_t const n, struct interpolation const ** const interpolations, char const ** const labels)
+{
+    for(size_t i = 0; i != n; i++) {
+        interpolations[i] = piecewise_linear_interpolation(&interpolation_function, settings->start, settings->end, orders[i]);
+        labels[i] = NULL;
+    }
+}
+
+static void raised_cosine_fit(struct settings const * const settings, unsigned long const * const orders, size_t const n, struct interpolation const ** const interpolations, char const ** const labels)
+{
+    for(size_t i = 0; i != n; i++) {
+        interpolations[i] = raised_cosine_interpolation(&interpolation_function, settings->start, settings->end, orders[i]);
+        labels[i] = NULL;
+    }
+}
+
+/* Natural splines of every order, and a clamped one of the last */
+static void cubic_spline_fit(struct settings const * const settings, unsigned long const * const orders, size_t const n, struct interpolation const ** const interpolations, char const ** const labels)
+{
+    for(size_t i = 0; i != n; i++) {
+        interpolations[i] = cubic_spline_interpolation(&interpolation_function, NULL, settings->start, settings->end, orders[i]);
+        labels[i] = "natural";
+    }
+    interpolations[n] = cubic_spline_interpolation(&interpolation_function, &interpolation_function_derivative, settings->start, settings->end, orders[n - 1]);
+    labels[n] = "clamped";
+}
+
+static void least_squares_fit(struct settings const * const settings, unsigned long const * const orders, size_t const n, struct interpolation const ** const interpolations, char const ** const labels)
+{
+    for(size_t i = 0; i != n; i++) {
+        interpolations[i] = streaming_least_squares_interpolation(&interpolation_function, settings->start, settings->end, orders[i], LEAST_SQUARES_POINTS);
+        labels[i] = NULL;
+    }
+}
+
+static struct interpolation_family const lagrange_family = {
+    "lagrange",
+    "Lagrange interpolation coefficients for %s\n",
+    polynomial_value,
+    polynomial_values,
+    polynomial_error,
+    polynomial_error_adaptive,
+    1,
+    default_orders,
+    3,
+    1,
+    0,
+    lagrange_fit
+};
+
+static struct interpolation_family const barycentric_family = {
+    NULL,
+    "Barycentric Lagrange interpolation of %s\n",
+    barycentric_value,
+    barycentric_values,
+    barycentric_error,
+    barycentric_error_adaptive,
+    0,
+    default_orders,
+    3,
+    2,
+    0,
+    barycentric_fit
+};
+
+static struct interpolation_family const chebyshev_family = {
+    "chebyshev",
+    "Chebyshev interpolation of %s\n",
+    chebyshev_value,
+    chebyshev_values,
+    chebyshev_error,
+    chebyshev_error_adaptive,
+    0,
+    chebyshev_orders,
+    4,
+    1,
+    0,
+    chebyshev_fit
+};
+
+static struct interpolation_family const piecewise_linear_family = {
+    "piecewise_linear",
+    "Piecewise linear interpolation coefficients for %s\n",
+    piecewise_linear_value,
+    piecewise_linear_values,
+    piecewise_linear_error,
+    piecewise_linear_error_adaptive,
+    0,
+    default_orders,
+    3,
+    1,
+    0,
+    piecewise_linear_fit
+};
+
+static struct interpolation_family const raised_cosine_family = {
+    "raised_cosine",
+    "Raised cosine interpolation coefficients for %s\n",
+    raised_cosine_value,
+    raised_cosine_values,
+    raised_cosine_error,
+    raised_cosine_error_adaptive,
+    0,
+    default_orders,
+    3,
+    1,
+    0,
+    raised_cosine_fit
+};
+
+static struct interpolation_family const cubic_spline_family = {
+    "cubic_spline",
+    "Cubic spline interpolation of %s\n",
+    cubic_spline_value,
+    cubic_spline_values,
+    cubic_spline_error,
+    cubic_spline_error_adaptive,
+    0,
+    default_orders,
+    3,
+    1,
+    1,
+    cubic_spline_fit
+};
+
+static struct interpolation_family const least_squares_family = {
+    "least_squares",
+    "Least squares interpolation coefficients for %s\n",
+    polynomial_value,
+    polynomial_values,
+    polynomial_error,
+    polynomial_error_adaptive,
+    1,
+    default_orders,
+    3,
+    1,
+    0,
+    least_squares_fit
+};
+
+/* One task of the graph main() runs. Everything it prints goes to out, an
+ * in-memory stream copied to stdout in task order once all have finished */
+struct job {
+    int (*run)(struct job*);
+    /* Stages that are a single task */
+    int (*stage)(struct settings const*, FILE*);
+    /* Interpolation stages: the shared state, and which interpolation an error task reports */
+    struct interpolation_stage* interpolation;
+    size_t index;
+    struct settings const* settings;
+    size_t stage_index;
+    FILE* out;
+    char* buffer;
+    size_t size;
+};
+
+static int run_job(void * const arg)
+{
+    struct job * const job = arg;
+    return job->run(job);
+}
+
+static int stage_job(struct job * const job)
+{
+    return job->stage(job->settings, job->out);
+}
+
+static int fit_job(struct job * const job)
+{
+    struct interpolation_stage * const stage = job->interpolation;
+    struct interpolation_family const * const family = stage->family;
+    unsigned long const* orders;
+    size_t const n_orders = stage_orders(job->settings, family, &orders);
+    stage->n = family->interpolations_per_order * n_orders + family->extra_interpolations;
+    family->fit(job->settings, orders, n_orders, stage->interpolations, stage->labels);
+    for(size_t i = 0; i != stage->n; i++) {
+        if(stage->interpolations[i] == NULL) {
+            return 1;
         }
-    };
-    gnuplot("raised_cosine", 4, -5.0L, 5.0L, EXPORT_POINTS, &interpolation_function, &raised_cosine_functions[0], &raised_cosine_functions[1], &raised_cosine_functions[2]);
+        stage->functions[i].name = stage->interpolations[i]->name;
+        stage->functions[i].f = (long double(*)(long double, void const*))family->value;
+        stage->functions[i].arg = stage->interpolations[i];
+        stage->functions[i].f_batch = (void(*)(long double const*, long double*, size_t, void const*))family->values;
+    }
+    fprintf(job->out, family->title, interpolation_function.name);
+    return 0;
+}
 
-    printf("Raised cosine interpolation coefficients for %s\n", interpolation_function.name);
-    for(int i = 0; i != 3; i++) {
-        printf(" order: %ld, error: %.2LE\n", raised_cosine[i]->order, raised_cosine_error(raised_cosine[i]));
-        destroy_interpolation((struct interpolation*)raised_cosine[i]);
+static int export_job(struct job * const job)
+{
+    struct interpolation_stage const * const stage = job->interpolation;
+    struct function const* plotted[MAX_INTERPOLATIONS + 1];
+    plotted[0] = &interpolation_function;
+    for(size_t i = 0; i != stage->n; i++) {
+        plotted[i + 1] = &stage->functions[i];
     }
+    gnuplot_functions(&job->settings->export_options, stage->family->base, stage->n + 1, job->settings->start, job->settings->end, job->settings->export_points, plotted);
+    return 0;
+}
 
-    struct interpolation const* least_squares[] = {
-        least_squares_interpolation(&interpolation_function, -5.0L, 5.0L, 5),
-        least_squares_interpolation(&interpolation_function, -5.0L, 5.0L, 10),
-        least_squares_interpolation(&interpolation_function, -5.0L, 5.0L, 20)
-    };
+static int error_job(struct job * const job)
+{
+    struct interpolation_stage const * const stage = job->interpolation;
+    struct interpolation_family const * const family = stage->family;
+    struct interpolation const * const interpolation = stage->interpolations[job->index];
+    if(family->print_coefficients) {
+        for(ssize_t j = interpolation->order; j >= 0; j--) {
+            fprintf(job->out, "%.4LE x**%ld%s", fabsl(interpolation->coefficients[j]), j, j == 0 ? "" : (interpolation->coefficients[j - 1] < 0.0L ? " - " : " + "));
+        }
+    }
+    struct result const adaptive_error = family->error_adaptive(interpolation, ERROR_TOLERANCE);
+    fprintf(job->out, " order: %ld, ", interpolation->order);
+    if(stage->labels[job->index] != NULL) {
+        fprintf(job->out, "%s, ", stage->labels[job->index]);
+    }
+    fprintf(job->out, "error: %.2LE, adaptive error: %.2LE (%lu evaluations)\n", family->error(interpolation), adaptive_error.value, adaptive_error.evaluations);
+    return 0;
+}
+
+/* In the order they print when none is named. Stages share no data and run
+ * concurrently; an interpolation stage is split into a fit task, an export
+ * task and an error task per interpolation, the last two waiting on the fit */
+static struct {
+    char const* name;
+    char const* description;
+    int (*run)(struct settings const*, FILE*);
+    struct interpolation_family const* family;
+} const stages[] = {
+    {"visual", "export the study function for visual inspection", visual_inspection_stage, NULL},
+    {"roots", "bisection, Brent, Illinois, secant, root isolation and Newton", roots_stage, NULL},
+    {"multiple_root", "Newton and altered Newton on a root of multiplicity 4", multiple_root_stage, NULL},
+    {"lagrange", "Lagrange interpolation", NULL, &lagrange_family},
+    {"barycentric", "barycentric Lagrange interpolation on uniform and Chebyshev nodes", NULL, &barycentric_family},
+    {"chebyshev", "Chebyshev interpolation", NULL, &chebyshev_family},
+    {"piecewise_linear", "piecewise linear interpolation", NULL, &piecewise_linear_family},
+    {"raised_cosine", "raised cosine interpolation", NULL, &raised_cosine_family},
+    {"cubic_spline", "natural and clamped cubic splines", NULL, &cubic_spline_family},
+    {"least_squares", "least squares fitting", NULL, &least_squares_family},
+    {"square_root", "square_root_values() against sqrtl() for k in [10, 10000]", square_root_stage, NULL},
+    {"adjusting_newton", "Newton and adjusting Newton on bonus problem 2", adjusting_newton_stage, NULL}
+};
+
+#define N_STAGES (sizeof(stages) / sizeof(stages[0]))
 
-    struct function const least_squares_functions[] = {
-        {
-            least_squares[0]->name,
-            (long double(*)(long double, void const*))polynomial_value,
-            least_squares[0]
-        },
-        {
-            least_squares[1]->name,
-            (long double(*)(long double, void const*))polynomial_value,
-            least_squares[1]
-        },
-        {
-            least_squares[2]->name,
-            (long double(*)(long double, void const*))polynomial_value,
-            least_squares[2]
+static void usage(char const * const name)
+{
+    fprintf(stderr,
+            "Usage: %s [options] [stage...]\n"
+            "Runs the given stages, or all of them, concurrently; output follows the order below.\n"
+            "\n"
+            "Options:\n"
+            "  --interval START:END    interval to interpolate on (default -5:5)\n"
+            "  --roots-interval START:END\n"
+            "                          interval to plot and scan for roots (default 0:10)\n"
+            "  --orders N[,N...]       interpolation orders (default: each stage's own)\n"
+            "  --output DIR            write the exported files to DIR, creating it\n"
+            "  --precision NAME        float, double or long double\n"
+            "  --threads N             worker threads\n"
+            "  --format csv|binary     exported data format (default binary)\n"
+            "  --decimation none|minmax|lttb\n"
+            "                          exported data decimation (default minmax)\n"
+            "  --points N              points written per decimated series (default %ld)\n"
+            "  --export-points N       points evaluated per exported series (default %ld)\n"
+            "\n"
+            "Stages:\n", name, PLOT_POINTS, EXPORT_POINTS);
+    for(size_t i = 0; i != N_STAGES; i++) {
+        fprintf(stderr, "  %-22s  %s\n", stages[i].name, stages[i].description);
+    }
+}
+
+static char parse_interval(char const * const text, long double * const start, long double * const end)
+{
+    char* separator;
+    *start = strtold(text, &separator);
+    if(separator == text || *separator != ':') {
+        return 1;
+    }
+    char* rest;
+    *end = strtold(separator + 1, &rest);
+    return (rest == separator + 1 || *rest != '\0' || !(*start < *end)) ? 1 : 0;
+}
+
+static char parse_count(char const * const text, unsigned long * const count)
+{
+    char* end;
+    if(*text == '-') {
+        return 1;
+    }
+    *count = strtoul(text, &end, 10);
+    return (end == text || *end != '\0' || *count == 0) ? 1 : 0;
+}
+
+static char parse_orders(char const* text, struct settings * const settings)
+{
+    settings->n_orders = 0;
+    for(;;) {
+        char* end;
+        if(settings->n_orders == MAX_ORDERS || *text == '-') {
+            return 1;
+        }
+        unsigned long const order = strtoul(text, &end, 10);
+        if(end == text || order == 0) {
+            return 1;
+        }
+        settings->orders[settings->n_orders++] = order;
+        if(*end == '\0') {
+            return 0;
+        } else if(*end != ',') {
+            return 1;
         }
+        text = end + 1;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+
+    struct settings settings = {
+        -5.0L,
+        5.0L,
+        0.0L,
+        10.0L,
+        0,
+        {0},
+        {GNUPLOT_BINARY, GNUPLOT_DECIMATE_MINMAX, PLOT_POINTS},
+        EXPORT_POINTS
     };
-    gnuplot("least_squares", 4, -5.0L, 5.0L, EXPORT_POINTS, &interpolation_function, &least_squares_functions[0], &least_squares_functions[1], &least_squares_functions[2]);
-    printf("Least squares interpolation coefficients for %s\n", interpolation_function.name);
-    for(int i = 0; i != 3; i++) {
-        for(ssize_t j = least_squares[i]->order; j >= 0; j--) {
-            printf("%.4LE x**%ld%s", fabsl(least_squares[i]->coefficients[j]), j, j == 0 ? "" : (least_squares[i]->coefficients[j - 1] < 0.0L ? " - " : " + "));
+    char selected[N_STAGES] = {0};
+    char any_selected = 0;
+    char const* output = NULL;
+
+    for(int i = 1; i < argc; i++) {
+        char const * const option = argv[i];
+        if(strncmp(option, "--", 2) != 0) {
+            size_t j = 0;
+            while(j != N_STAGES && strcmp(option, stages[j].name) != 0) {
+                j++;
+            }
+            if(j == N_STAGES) {
+                fprintf(stderr, "%s: Unknown stage %s\n", argv[0], option);
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            selected[j] = 1;
+            any_selected = 1;
+            continue;
+        }
+        if(strcmp(option, "--help") == 0) {
+            usage(argv[0]);
+            return EXIT_SUCCESS;
+        }
+        if(i + 1 == argc) {
+            fprintf(stderr, "%s: %s needs a value\n", argv[0], option);
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        char const * const value = argv[++i];
+        char invalid = 0;
+        unsigned long count;
+        if(strcmp(option, "--interval") == 0) {
+            invalid = parse_interval(value, &settings.start, &settings.end);
+        } else if(strcmp(option, "--roots-interval") == 0) {
+            invalid = parse_interval(value, &settings.roots_start, &settings.roots_end);
+        } else if(strcmp(option, "--orders") == 0) {
+            invalid = parse_orders(value, &settings);
+        } else if(strcmp(option, "--output") == 0) {
+            output = value;
+        } else if(strcmp(option, "--precision") == 0) {
+            enum precision precision;
+            invalid = parse_precision(value, &precision);
+            if(!invalid) {
+                set_precision(precision);
+            }
+        } else if(strcmp(option, "--threads") == 0) {
+            invalid = parse_count(value, &count);
+            if(!invalid) {
+                thread_pool_set_threads(count);
+            }
+        } else if(strcmp(option, "--format") == 0) {
+            if(strcmp(value, "csv") == 0) {
+                settings.export_options.format = GNUPLOT_CSV;
+            } else if(strcmp(value, "binary") == 0) {
+                settings.export_options.format = GNUPLOT_BINARY;
+            } else {
+                invalid = 1;
+            }
+        } else if(strcmp(option, "--decimation") == 0) {
+            if(strcmp(value, "none") == 0) {
+                settings.export_options.decimation = GNUPLOT_DECIMATE_NONE;
+            } else if(strcmp(value, "minmax") == 0) {
+                settings.export_options.decimation = GNUPLOT_DECIMATE_MINMAX;
+            } else if(strcmp(value, "lttb") == 0) {
+                settings.export_options.decimation = GNUPLOT_DECIMATE_LTTB;
+            } else {
+                invalid = 1;
+            }
+        } else if(strcmp(option, "--points") == 0) {
+            invalid = parse_count(value, &count);
+            if(!invalid) {
+                settings.export_options.target_points = count;
+            }
+        } else if(strcmp(option, "--export-points") == 0) {
+            invalid = parse_count(value, &settings.export_points);
+        } else {
+            fprintf(stderr, "%s: Unknown option %s\n", argv[0], option);
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        if(invalid) {
+            fprintf(stderr, "%s: Invalid value %s for %s\n", argv[0], value, option);
+            return EXIT_FAILURE;
         }
-        printf(" order: %ld, error: %.2LE\n", least_squares[i]->order, polynomial_error(least_squares[i]));
-        destroy_interpolation((struct interpolation*)least_squares[i]);
     }
 
-    /* Bonus Problem 1 */
 
-    char square_root_errors = 0;
-    for(long double i = 10.0L; i <= 10000.0L; i += 1.0L / 8192.0L) {
-        struct result squareroot = square_root_calculator(i);
-        double long real_sqrt = sqrtl(i);
-        if(labs(squareroot.value - real_sqrt) > squareroot.error) {
-            square_root_errors++;
-            printf("Error for square root of %.0Lf (%Lf ± %LE not %Lf) \n", i, squareroot.value, squareroot.error, real_sqrt);
+    if(output != NULL) {
+        if(mkdir(output, 0777) != 0 && errno != EEXIST) {
+            fprintf(stderr, "%s: Unable to create %s\n", argv[0], output);
+            return EXIT_FAILURE;
+        }
+        if(chdir(output) != 0) {
+            fprintf(stderr, "%s: Unable to change to %s\n", argv[0], output);
+            return EXIT_FAILURE;
         }
     }
-    if(square_root_errors == 0) {
-        printf("Success for square root\n");
+
+    int status = EXIT_FAILURE;
+    char failed[N_STAGES] = {0};
+    size_t n_jobs = 0;
+    struct job * const jobs = calloc(N_STAGES * (MAX_INTERPOLATIONS + 2), sizeof(struct job));
+    struct interpolation_stage * const interpolation_stages = calloc(N_STAGES, sizeof(struct interpolation_stage));
+    struct task_graph * const graph = create_task_graph();
+    if(jobs == NULL || interpolation_stages == NULL || graph == NULL) {
+        fprintf(stderr, "%s: Unable to allocate the stages\n", argv[0]);
+        goto cleanup;
     }
 
-    /* Bonus Problem 2 */
-    struct result const bonus_newtons_result[] = {
-        newtons_method(&bonus_functions[0], &bonus_function_derivatives[0], 5.0L, 256, TOLERANCE),
-        newtons_method(&bonus_functions[1], &bonus_function_derivatives[1], 5.0L, 256, TOLERANCE)
-    };
-    struct result const adjusting_bonus_newtons_result[] = {
-        adjusting_newtons_method(&bonus_functions[0], &bonus_function_derivatives[0], 5.0L, 256, TOLERANCE),
-        adjusting_newtons_method(&bonus_functions[1], &bonus_function_derivatives[1], 5.0L, 256, TOLERANCE)
-    };
+    /* Jobs are added, and their output printed, in stage order */
+    for(size_t i = 0; i != N_STAGES; i++) {
+        if(any_selected && !selected[i]) {
+            continue;
+        }
+        struct interpolation_family const * const family = stages[i].family;
+        size_t const n_interpolations = (family == NULL) ? 0 : stage_interpolations(&settings, family);
+        size_t const first = n_jobs;
+        size_t const n_stage_jobs = (family == NULL) ? 1 : 1 + (family->base != NULL) + n_interpolations;
+        interpolation_stages[i].family = family;
+        for(size_t j = 0; j != n_stage_jobs; j++) {
+            struct job * const job = &jobs[n_jobs];
+            job->settings = &settings;
+            job->stage_index = i;
+            job->interpolation = &interpolation_stages[i];
+            if(family == NULL) {
+                job->run = stage_job;
+                job->stage = stages[i].run;
+            } else if(j == 0) {
+                job->run = fit_job;
+            } else if(j == 1 && family->base != NULL) {
+                job->run = export_job;
+            } else {
+                job->run = error_job;
+                job->index = j - 1 - (family->base != NULL);
+            }
+            job->out = open_memstream(&job->buffer, &job->size);
+            if(job->out == NULL) {
+                fprintf(stderr, "%s: Unable to open the output of stage %s\n", argv[0], stages[i].name);
+                goto cleanup;
+            }
+            n_jobs++;
+            if(task_graph_add(graph, run_job, job) != n_jobs - 1 || (j != 0 && task_graph_depend(graph, n_jobs - 1, first) != 0)) {
+                fprintf(stderr, "%s: Unable to schedule stage %s\n", argv[0], stages[i].name);
+                goto cleanup;
+            }
+        }
+    }
 
-    printf("Bonus Problem 2: Adjusting Newton's Method\n");
-    for(int i = 0; i != 2; i++) {
-        printf("function %s:\n", bonus_functions[i].name);
-        report_result(&bonus_newtons_result[i]);
-        report_result(&adjusting_bonus_newtons_result[i]);
+    task_graph_run(graph);
+
+    for(size_t i = 0; i != n_jobs; i++) {
+        fclose(jobs[i].out);
+        jobs[i].out = NULL;
+        fwrite(jobs[i].buffer, 1, jobs[i].size, stdout);
+        if(task_graph_failed(graph, i)) {
+            failed[jobs[i].stage_index] = 1;
+        }
+    }
+    status = EXIT_SUCCESS;
+    for(size_t i = 0; i != N_STAGES; i++) {
+        if(failed[i]) {
+            fprintf(stderr, "%s: Stage %s failed\n", argv[0], stages[i].name);
+            status = EXIT_FAILURE;
+        }
     }
 
-    return EXIT_SUCCESS;
+cleanup:
+    for(size_t i = 0; i != n_jobs; i++) {
+        if(jobs[i].out != NULL) {
+            fclose(jobs[i].out);
+        }
+        free(jobs[i].buffer);
+    }
+    if(interpolation_stages != NULL) {
+        for(size_t i = 0; i != N_STAGES; i++) {
+            for(size_t j = 0; j != interpolation_stages[i].n; j++) {
+                if(interpolation_stages[i].interpolations[j] != NULL) {
+                    destroy_interpolation((struct interpolation*)interpolation_stages[i].interpolations[j]);
+                }
+            }
+        }
+    }
+    destroy_task_graph(graph);
+    free(interpolation_stages);
+    free(jobs);
+    return status;
 }
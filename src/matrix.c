@@ -25,7 +25,179 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <pthread.h>
 #include "matrix.h"
+#include "precision.h"
+#include "thread_pool.h"
+
+/* Tile edge for transpose_matrix() */
+#define TRANSPOSE_BLOCK 32L
+/* Minimum number of multiply-adds per task of a parallel row reduction */
+#define REDUCTION_GRAIN 16384L
+
+/* Diagonal block size of the blocked Cholesky factorisation */
+#define CHOLESKY_BLOCK 64L
+/* Offset of element (i, j), j <= i, in packed lower-triangular storage */
+#define CHOLESKY_INDEX(i, j) ((i) * ((i) + 1L) / 2L + (j))
+
+/* Products with fewer multiply-adds than this, and matrix-vector products,
+ * use the naive kernel */
+#define GEMM_NAIVE_LIMIT 32768L
+
+#define GEMM_T long double
+#define GEMM_SUFFIX ld
+/* x87 only has an 8-deep register stack, larger blocks spill */
+#define GEMM_MR 2
+#define GEMM_NR 2
+#include "gemm_template.h"
+#undef GEMM_T
+#undef GEMM_SUFFIX
+#undef GEMM_MR
+#undef GEMM_NR
+
+#define GEMM_CONVERT
+#define GEMM_T double
+#define GEMM_SUFFIX d
+#define GEMM_MR 4
+#define GEMM_NR 8
+#include "gemm_template.h"
+#undef GEMM_T
+#undef GEMM_SUFFIX
+#undef GEMM_MR
+#undef GEMM_NR
+
+#define GEMM_T float
+#define GEMM_SUFFIX f
+#define GEMM_MR 4
+#define GEMM_NR 16
+#include "gemm_template.h"
+#undef GEMM_T
+#undef GEMM_SUFFIX
+#undef GEMM_MR
+#undef GEMM_NR
+#undef GEMM_CONVERT
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define GEMM_HAVE_X86_KERNELS
+
+/* AVX2 micro-kernel: 4 × 8 block held in 8 ymm accumulators */
+__attribute__((target("avx2,fma")))
+static void gemm_micro_kernel_avx2_d(size_t const kc, double const * a, double const * b, double * const c, size_t const ldc, size_t const m, size_t const n)
+{
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+    for(size_t p = 0; p < kc; p++) {
+        __m256d const b0 = _mm256_loadu_pd(b);
+        __m256d const b1 = _mm256_loadu_pd(b + 4);
+        __m256d a0 = _mm256_broadcast_sd(a);
+        c00 = _mm256_fmadd_pd(a0, b0, c00);
+        c01 = _mm256_fmadd_pd(a0, b1, c01);
+        a0 = _mm256_broadcast_sd(a + 1);
+        c10 = _mm256_fmadd_pd(a0, b0, c10);
+        c11 = _mm256_fmadd_pd(a0, b1, c11);
+        a0 = _mm256_broadcast_sd(a + 2);
+        c20 = _mm256_fmadd_pd(a0, b0, c20);
+        c21 = _mm256_fmadd_pd(a0, b1, c21);
+        a0 = _mm256_broadcast_sd(a + 3);
+        c30 = _mm256_fmadd_pd(a0, b0, c30);
+        c31 = _mm256_fmadd_pd(a0, b1, c31);
+        a += 4;
+        b += 8;
+    }
+    double acc[4][8];
+    _mm256_storeu_pd(acc[0], c00);
+    _mm256_storeu_pd(acc[0] + 4, c01);
+    _mm256_storeu_pd(acc[1], c10);
+    _mm256_storeu_pd(acc[1] + 4, c11);
+    _mm256_storeu_pd(acc[2], c20);
+    _mm256_storeu_pd(acc[2] + 4, c21);
+    _mm256_storeu_pd(acc[3], c30);
+    _mm256_storeu_pd(acc[3] + 4, c31);
+    for(size_t i = 0; i < m; i++) {
+        for(size_t j = 0; j < n; j++) {
+            c[i * ldc + j] += acc[i][j];
+        }
+    }
+}
+
+/* AVX-512 micro-kernel: 8 × 16 block held in 16 zmm accumulators */
+__attribute__((target("avx512f")))
+static void gemm_micro_kernel_avx512_d(size_t const kc, double const * a, double const * b, double * const c, size_t const ldc, size_t const m, size_t const n)
+{
+    __m512d acc0[8], acc1[8];
+    for(size_t i = 0; i < 8; i++) {
+        acc0[i] = _mm512_setzero_pd();
+        acc1[i] = _mm512_setzero_pd();
+    }
+    for(size_t p = 0; p < kc; p++) {
+        __m512d const b0 = _mm512_loadu_pd(b);
+        __m512d const b1 = _mm512_loadu_pd(b + 8);
+        for(size_t i = 0; i < 8; i++) {
+            __m512d const ai = _mm512_set1_pd(a[i]);
+            acc0[i] = _mm512_fmadd_pd(ai, b0, acc0[i]);
+            acc1[i] = _mm512_fmadd_pd(ai, b1, acc1[i]);
+        }
+        a += 8;
+        b += 16;
+    }
+    double acc[8][16];
+    for(size_t i = 0; i < 8; i++) {
+        _mm512_storeu_pd(acc[i], acc0[i]);
+        _mm512_storeu_pd(acc[i] + 8, acc1[i]);
+    }
+    for(size_t i = 0; i < m; i++) {
+        for(size_t j = 0; j < n; j++) {
+            c[i * ldc + j] += acc[i][j];
+        }
+    }
+}
+
+static struct gemm_kernel_d const gemm_avx2_kernel_d = {
+    "avx2",
+    4,
+    8,
+    gemm_micro_kernel_avx2_d
+};
+
+static struct gemm_kernel_d const gemm_avx512_kernel_d = {
+    "avx512",
+    8,
+    16,
+    gemm_micro_kernel_avx512_d
+};
+#endif
+
+/* Pick the widest double micro-kernel the running CPU supports */
+static struct gemm_kernel_d const* gemm_select_kernel_d(void)
+{
+#ifdef GEMM_HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f")) {
+        return &gemm_avx512_kernel_d;
+    }
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return &gemm_avx2_kernel_d;
+    }
+#endif
+    return &gemm_portable_kernel_d;
+}
+
+static struct gemm_kernel_d const* double_kernel;
+static pthread_once_t double_kernel_once = PTHREAD_ONCE_INIT;
+
+static void select_double_kernel(void)
+{
+    double_kernel = gemm_select_kernel_d();
+}
+
+static struct gemm_kernel_d const* matrix_double_kernel(void)
+{
+    pthread_once(&double_kernel_once, select_double_kernel);
+    return double_kernel;
+}
 
 struct matrix* create_matrix(size_t const cols, size_t const rows) {
     if(cols == 0 || rows == 0) {
@@ -40,10 +212,73 @@ struct matrix* create_matrix(size_t const cols, size_t const rows) {
         }
         matrix->rows = rows;
         matrix->cols = cols;
+        matrix->offset = 0L;
+        matrix->row_stride = cols;
+        matrix->col_stride = 1L;
     }
     return matrix;
 }
 
+struct matrix matrix_view_array(long double * const elements, size_t const cols, size_t const rows)
+{
+    struct matrix const view = {
+        elements,
+        cols,
+        rows,
+        0L,
+        cols,
+        1L
+    };
+    return view;
+}
+
+struct matrix matrix_view_transpose(struct matrix const * const matrix)
+{
+    struct matrix const view = {
+        matrix->elements,
+        matrix->rows,
+        matrix->cols,
+        matrix->offset,
+        matrix->col_stride,
+        matrix->row_stride
+    };
+    return view;
+}
+
+struct matrix matrix_view_block(struct matrix const * const matrix, size_t const row, size_t const col, size_t const rows, size_t const cols)
+{
+    if(row == 0 || col == 0 || rows == 0 || cols == 0 || row - 1L + rows > matrix->rows || col - 1L + cols > matrix->cols) {
+        struct matrix const empty = {
+            NULL,
+            0L,
+            0L,
+            0L,
+            0L,
+            0L
+        };
+        return empty;
+    }
+    struct matrix const view = {
+        matrix->elements,
+        cols,
+        rows,
+        matrix->offset + (row - 1L) * matrix->row_stride + (col - 1L) * matrix->col_stride,
+        matrix->row_stride,
+        matrix->col_stride
+    };
+    return view;
+}
+
+struct matrix matrix_view_row(struct matrix const * const matrix, size_t const row)
+{
+    return matrix_view_block(matrix, row, 1L, 1L, matrix->cols);
+}
+
+struct matrix matrix_view_col(struct matrix const * const matrix, size_t const col)
+{
+    return matrix_view_block(matrix, 1L, col, matrix->rows, 1L);
+}
+
 void destroy_matrix(struct matrix * const matrix)
 {
     free(matrix->elements);
@@ -55,9 +290,9 @@ void matrix_set_row(struct matrix * const matrix, size_t const row, long double
     if(row == 0 || row > matrix->rows) {
         return;
     }
-    long double * const rowp = matrix->elements + (row - 1L) * matrix->cols;
+    long double * const rowp = matrix->elements + matrix->offset + (row - 1L) * matrix->row_stride;
     for(size_t i = 0; i != matrix->cols; i++) {
-        rowp[i] = value;
+        rowp[i * matrix->col_stride] = value;
     }
 }
 
@@ -66,9 +301,9 @@ void matrix_set_row_vector(struct matrix * const matrix, size_t const row, long
     if(row == 0 || row > matrix->rows) {
         return;
     }
-    long double * const rowp = matrix->elements + (row - 1L) * matrix->cols;
+    long double * const rowp = matrix->elements + matrix->offset + (row - 1L) * matrix->row_stride;
     for(size_t i = 0; i != matrix->cols; i++) {
-        rowp[i] = vector[i];
+        rowp[i * matrix->col_stride] = vector[i];
     }
 }
 
@@ -77,138 +312,453 @@ void matrix_set_row_vector_power(struct matrix* const matrix, size_t const row,
     if(row == 0 || row > matrix->rows) {
         return;
     }
-    long double * const rowp = matrix->elements + (row - 1L) * matrix->cols;
+    long double * const rowp = matrix->elements + matrix->offset + (row - 1L) * matrix->row_stride;
     for(size_t i = 0; i != matrix->cols; i++) {
-        rowp[i] = powl(vector[i], power);
+        rowp[i * matrix->col_stride] = powl(vector[i], power);
+    }
+}
+
+struct transpose_job {
+    struct matrix const* matrix;
+    struct matrix* transpose;
+};
+
+/* Transposes rows [begin, end) of the source in TRANSPOSE_BLOCK-wide tiles */
+static void transpose_task(size_t const begin, size_t const end, void * const arg)
+{
+    struct transpose_job const * const job = arg;
+    struct matrix const * const matrix = job->matrix;
+    for(size_t jb = 0; jb < matrix->cols; jb += TRANSPOSE_BLOCK) {
+        size_t const j_end = (matrix->cols - jb < TRANSPOSE_BLOCK) ? matrix->cols : jb + TRANSPOSE_BLOCK;
+        for(size_t i = begin; i < end; i++) {
+            for(size_t j = jb; j < j_end; j++) {
+                job->transpose->elements[i + j * (matrix->rows)] = MATRIX_ELEMENT(matrix, i, j);
+            }
+        }
     }
 }
 
 struct matrix* transpose_matrix(struct matrix const * const matrix) {
     struct matrix * const transpose = create_matrix(matrix->rows, matrix->cols);
     if(transpose != NULL) {
-        for(size_t i = 0; i < matrix->rows; i++) {
-            for(size_t j = 0; j < matrix->cols; j++) {
-                transpose->elements[i + j * (matrix->rows)] = matrix->elements[j + i * (matrix->cols)];
-            }
-        }
+        struct transpose_job job = {
+            matrix,
+            transpose
+        };
+        parallel_for(matrix->rows, TRANSPOSE_BLOCK, transpose_task, &job);
     }
     return transpose;
 }
 
+struct matrix* matrix_multiply_naive(struct matrix const * const A, struct matrix const * const B) {
+    if(A->cols != B->rows) {
+        printf("Dimensions mismatch: A: (cols: %ld, rows: %ld), B: (cols: %ld, rows: %ld)\n", A->cols, A->rows, B->cols, B->rows);
+        return NULL;
+    }
+    struct matrix * const result = create_matrix(B->cols, A->rows);
+    if(result != NULL) {
+        gemm_naive_ld(A->rows, B->cols, A->cols, A->elements + A->offset, A->row_stride, A->col_stride, B->elements + B->offset, B->row_stride, B->col_stride, result->elements, result->cols);
+    }
+    return result;
+}
+
 struct matrix* matrix_multiply(struct matrix const * const A, struct matrix const * const B) {
     if(A->cols != B->rows) {
         printf("Dimensions mismatch: A: (cols: %ld, rows: %ld), B: (cols: %ld, rows: %ld)\n", A->cols, A->rows, B->cols, B->rows);
         return NULL;
     }
+    if(B->cols == 1L || A->rows * B->cols * A->cols < GEMM_NAIVE_LIMIT) {
+        return matrix_multiply_naive(A, B);
+    }
     struct matrix * const result = create_matrix(B->cols, A->rows);
     if(result != NULL) {
-        for(size_t i = 0; i < A->rows; i++) {
-            for(size_t j = 0; j < B->cols; j++) {
-                result->elements[j + i * B->cols] = 0.0L;
-                for(size_t k = 0; k < A->cols; k++) {
-                    result->elements[j + i * B->cols] += A->elements[i * A->cols + k] * B->elements[k * B->cols + j];
-                }
-            }
+        char failed;
+        switch(get_precision()) {
+        case PRECISION_FLOAT:
+            failed = gemm_convert_f(A, B, result, &gemm_portable_kernel_f);
+            break;
+        case PRECISION_DOUBLE:
+            failed = gemm_convert_d(A, B, result, matrix_double_kernel());
+            break;
+        default:
+            failed = gemm_parallel_ld(A->rows, B->cols, A->cols, A->elements + A->offset, A->row_stride, A->col_stride, B->elements + B->offset, B->row_stride, B->col_stride, result->elements, result->cols, &gemm_portable_kernel_ld);
+            break;
+        }
+        if(failed) {
+            destroy_matrix(result);
+            return NULL;
         }
     }
     return result;
 }
 
-/* Helper for Gaussian reduction */
-static char matrix_scale_row(struct matrix * const matrix, struct matrix * const secondary_matrix, size_t const row, size_t const col, long double const scale_to)
+char matrix_multiply_double(size_t const m, size_t const n, size_t const k, double const * const A, double const * const B, double * const C)
 {
-    if(row == 0L || row > matrix->rows || col == 0L || col > matrix->cols) {
-        return 1;
+    if(n == 1L || m * n * k < GEMM_NAIVE_LIMIT) {
+        gemm_naive_d(m, n, k, A, k, 1L, B, n, 1L, C, n);
+        return 0;
     }
-    long double element = matrix->elements[(row - 1L) * matrix->cols + col - 1L];
-    if(element == 0.0L) {
-        for(size_t i = 0L; i != matrix->rows; i++) {
-            element = (matrix->elements[i * matrix->cols + col - 1L]);
-            if(element != 0.0L) {
-                for(size_t j = 0L; j < matrix->cols; j++) {
-                    matrix->elements[(row - 1L)*matrix->cols + i] += matrix->elements[i * matrix->cols + col];
-                    secondary_matrix->elements[(row - 1L)*matrix->cols + i] += secondary_matrix->elements[i * matrix->cols + col];
-                }
+    return gemm_parallel_d(m, n, k, A, k, 1L, B, n, 1L, C, n, matrix_double_kernel());
+}
+
+char const* matrix_multiply_double_kernel(void)
+{
+    return matrix_double_kernel()->name;
+}
+
+struct lu_update_job {
+    struct matrix* lu;
+    size_t pivot;
+};
+
+/* Eliminates column job->pivot from rows job->pivot + 1 + [begin, end) */
+static void lu_update_task(size_t const begin, size_t const end, void * const arg)
+{
+    struct lu_update_job const * const job = arg;
+    size_t const n = job->lu->cols, k = job->pivot;
+    long double const * const pivot_row = job->lu->elements + k * n;
+    for(size_t i = k + 1L + begin; i != k + 1L + end; i++) {
+        long double * const row = job->lu->elements + i * n;
+        long double const l = row[k] / pivot_row[k];
+        row[k] = l;
+        if(l != 0.0L) {
+            for(size_t j = k + 1L; j < n; j++) {
+                row[j] -= l * pivot_row[j];
             }
         }
-        if(element == 0.0L) {
-            return 1;
+    }
+}
+
+struct lu_factorization* lu_factor(struct matrix const * const matrix) {
+    if(matrix->rows != matrix->cols) {
+        return NULL;
+    }
+    size_t const n = matrix->rows;
+    struct lu_factorization * const factorization = malloc(sizeof(struct lu_factorization));
+    if(factorization == NULL) {
+        return NULL;
+    }
+    factorization->lu = create_matrix(n, n);
+    factorization->pivots = malloc(sizeof(size_t) * n);
+    if(factorization->lu == NULL || factorization->pivots == NULL) {
+        if(factorization->lu != NULL) {
+            destroy_matrix(factorization->lu);
         }
-        element = matrix->elements[(row - 1L) * matrix->cols + col - 1L];
+        free(factorization->pivots);
+        free(factorization);
+        return NULL;
     }
-    long double const scale = scale_to / element;
-    if(!isfinite(scale)) {
-        return 1;
+    long double * const lu = factorization->lu->elements;
+    for(size_t i = 0; i < n; i++) {
+        for(size_t j = 0; j < n; j++) {
+            lu[i * n + j] = MATRIX_ELEMENT(matrix, i, j);
+        }
+        factorization->pivots[i] = i;
     }
-    if(scale != 1.0L) {
-        for(size_t i = 0; i < matrix->cols; i++) {
-            matrix->elements[(row - 1L)*matrix->cols + i] *= scale;
-            secondary_matrix->elements[(row - 1L)*matrix->cols + i] *= scale;
+    struct lu_update_job job = {
+        factorization->lu,
+        0
+    };
+    size_t const grain = 1L + REDUCTION_GRAIN / (2L * n);
+    for(size_t k = 0; k < n; k++) {
+        /* Partial pivoting: bring up the row with the largest entry in column k */
+        size_t p = k;
+        for(size_t i = k + 1L; i < n; i++) {
+            if(fabsl(lu[i * n + k]) > fabsl(lu[p * n + k])) {
+                p = i;
+            }
+        }
+        if(lu[p * n + k] == 0.0L || !isfinite(lu[p * n + k])) {
+            destroy_lu_factorization(factorization);
+            return NULL;
         }
+        if(p != k) {
+            for(size_t j = 0; j < n; j++) {
+                long double const t = lu[k * n + j];
+                lu[k * n + j] = lu[p * n + j];
+                lu[p * n + j] = t;
+            }
+            size_t const t = factorization->pivots[k];
+            factorization->pivots[k] = factorization->pivots[p];
+            factorization->pivots[p] = t;
+        }
+        /* Rows below the pivot are independent of each other */
+        job.pivot = k;
+        parallel_for(n - k - 1L, grain, lu_update_task, &job);
     }
-    return 0;
+    return factorization;
 }
 
-/* Helper for Gaussian reduction */
-static char matrix_reduce_row(struct matrix * const matrix, struct matrix * const secondary_matrix, size_t const row_dst, size_t const row_src, size_t const col)
+void destroy_lu_factorization(struct lu_factorization * const factorization)
 {
-    if(row_src == row_dst || row_dst == 0L || row_dst > matrix->rows || row_src == 0L || row_src > matrix->rows || col == 0L || col > matrix->cols) {
-        return 1;
+    destroy_matrix(factorization->lu);
+    free(factorization->pivots);
+    free(factorization);
+}
+
+struct lu_solve_job {
+    struct lu_factorization const* factorization;
+    struct matrix* X;
+};
+
+/* Forward and back substitution for columns [begin, end) of X */
+static void lu_solve_task(size_t const begin, size_t const end, void * const arg)
+{
+    struct lu_solve_job const * const job = arg;
+    size_t const n = job->factorization->lu->rows, cols = job->X->cols;
+    long double const * const lu = job->factorization->lu->elements;
+    long double * const x = job->X->elements;
+    /* L y = P b, L has an implicit unit diagonal */
+    for(size_t i = 1; i < n; i++) {
+        for(size_t k = 0; k < i; k++) {
+            long double const l = lu[i * n + k];
+            for(size_t j = begin; j < end; j++) {
+                x[i * cols + j] -= l * x[k * cols + j];
+            }
+        }
     }
-    if(matrix->elements[(row_src - 1L)*matrix->cols + col - 1L] == 0.0L) {
-        return 1;
+    /* U x = y */
+    for(size_t i = n; i-- != 0;) {
+        for(size_t k = i + 1L; k < n; k++) {
+            long double const u = lu[i * n + k];
+            for(size_t j = begin; j < end; j++) {
+                x[i * cols + j] -= u * x[k * cols + j];
+            }
+        }
+        long double const u = lu[i * n + i];
+        for(size_t j = begin; j < end; j++) {
+            x[i * cols + j] /= u;
+        }
     }
-    long double const scale = matrix->elements[(row_dst - 1L) * matrix->cols + col - 1L];
-    if(scale != 0.0L) {
-        for(size_t i = 0L; i < matrix->cols; i++) {
-            matrix->elements[(row_dst - 1L)*matrix->cols + i] -= scale * matrix->elements[(row_src - 1L) * matrix->cols + i];
-            secondary_matrix->elements[(row_dst - 1L)*matrix->cols + i] -= scale * secondary_matrix->elements[(row_src - 1L) * matrix->cols + i];
+}
+
+struct matrix* lu_solve(struct lu_factorization const * const factorization, struct matrix const * const B) {
+    size_t const n = factorization->lu->rows;
+    if(B->rows != n) {
+        printf("Dimensions mismatch: LU: (cols: %ld, rows: %ld), B: (cols: %ld, rows: %ld)\n", n, n, B->cols, B->rows);
+        return NULL;
+    }
+    struct matrix * const X = create_matrix(B->cols, n);
+    if(X != NULL) {
+        for(size_t i = 0; i < n; i++) {
+            for(size_t j = 0; j < B->cols; j++) {
+                X->elements[i * B->cols + j] = MATRIX_ELEMENT(B, factorization->pivots[i], j);
+            }
         }
+        struct lu_solve_job job = {
+            factorization,
+            X
+        };
+        parallel_for(B->cols, 1L + REDUCTION_GRAIN / (n * n), lu_solve_task, &job);
     }
-    return 0;
+    return X;
 }
 
 struct matrix* matrix_inverse(struct matrix const * const matrix) {
-    if(matrix->rows != matrix->cols) {
+    struct lu_factorization * const factorization = lu_factor(matrix);
+    if(factorization == NULL) {
         return NULL;
     }
-    struct matrix *const temp = create_matrix(matrix->rows, matrix->cols);
-    if(temp != NULL) {
-        struct matrix *const inverse = create_matrix(matrix->rows, matrix->cols);
-        if(inverse != NULL) {
-            char result = 0;
-            /* Duplicate matrix into temp */
-            memcpy(temp->elements, matrix->elements, matrix->rows * matrix->cols * sizeof(long double));
-            /* Create identify matrix */
-            for(size_t i = 0; i < matrix->rows; i++) {
-                for(size_t j = 0; j < matrix->cols; j++) {
-                    inverse->elements[j + i * matrix->cols] = (i == j) ? 1.0L : 0.0L;
-                }
+    struct matrix * inverse = NULL;
+    struct matrix * const identity = create_matrix(matrix->rows, matrix->rows);
+    if(identity != NULL) {
+        for(size_t i = 0; i < matrix->rows; i++) {
+            for(size_t j = 0; j < matrix->cols; j++) {
+                identity->elements[j + i * matrix->cols] = (i == j) ? 1.0L : 0.0L;
             }
-            /* Do Gaussian reduction */
-            for(size_t i = 1; i <= matrix->rows && result == 0; i++) {
-                result = matrix_scale_row(temp, inverse, i, i, 1.0L);
-                for(size_t j = i + 1; j <= matrix->rows && result == 0; j++) {
-                    result = matrix_reduce_row(temp, inverse, j, i, i);
-                }
+        }
+        inverse = lu_solve(factorization, identity);
+        destroy_matrix(identity);
+    }
+    destroy_lu_factorization(factorization);
+    return inverse;
+}
+
+struct cholesky_job {
+    long double* l;
+    size_t block;
+    size_t block_end;
+};
+
+/* Unblocked Cholesky–Banachiewicz on rows/columns [begin, end) of the packed
+ * matrix, assuming columns before begin have already been eliminated from
+ * them. Returns 1 if a pivot is not positive. */
+static char cholesky_diagonal_block(long double * const l, size_t const begin, size_t const end)
+{
+    for(size_t i = begin; i < end; i++) {
+        long double * const row_i = l + CHOLESKY_INDEX(i, 0);
+        for(size_t j = begin; j <= i; j++) {
+            long double const * const row_j = l + CHOLESKY_INDEX(j, 0);
+            long double s = row_i[j];
+            for(size_t k = begin; k < j; k++) {
+                s -= row_i[k] * row_j[k];
             }
-            for(size_t i = matrix->rows; i >= 1 && result == 0; i--) {
-                for(size_t j = i - 1; j >= 1 && result == 0; j--) {
-                    result = matrix_reduce_row(temp, inverse, j, i, i);
+            if(i == j) {
+                if(!(s > 0.0L) || !isfinite(s)) {
+                    return 1;
                 }
+                row_i[i] = sqrtl(s);
+            } else {
+                row_i[j] = s / row_j[j];
+            }
+        }
+    }
+    return 0;
+}
+
+/* Panel solve for rows block_end + [begin, end):
+ * L[i][block] = A[i][block] * L[block][block]^-T */
+static void cholesky_panel_task(size_t const begin, size_t const end, void * const arg)
+{
+    struct cholesky_job const * const job = arg;
+    long double * const l = job->l;
+    for(size_t i = job->block_end + begin; i != job->block_end + end; i++) {
+        long double * const row_i = l + CHOLESKY_INDEX(i, 0);
+        for(size_t j = job->block; j < job->block_end; j++) {
+            long double const * const row_j = l + CHOLESKY_INDEX(j, 0);
+            long double s = row_i[j];
+            for(size_t k = job->block; k < j; k++) {
+                s -= row_i[k] * row_j[k];
+            }
+            row_i[j] = s / row_j[j];
+        }
+    }
+}
+
+/* Trailing update for rows block_end + [begin, end), once the whole panel is
+ * known: A[i][j] -= L[i][block] * L[j][block]^T */
+static void cholesky_update_task(size_t const begin, size_t const end, void * const arg)
+{
+    struct cholesky_job const * const job = arg;
+    long double * const l = job->l;
+    for(size_t i = job->block_end + begin; i != job->block_end + end; i++) {
+        long double * const row_i = l + CHOLESKY_INDEX(i, 0);
+        for(size_t j = job->block_end; j <= i; j++) {
+            long double const * const row_j = l + CHOLESKY_INDEX(j, 0);
+            long double s = 0.0L;
+            for(size_t k = job->block; k < job->block_end; k++) {
+                s += row_i[k] * row_j[k];
             }
-            if(result != 0) {
-                destroy_matrix(temp);
-                destroy_matrix(inverse);
-                return NULL;
+            row_i[j] -= s;
+        }
+    }
+}
+
+struct cholesky_factorization* cholesky_factor(struct matrix const * const matrix) {
+    if(matrix->rows != matrix->cols) {
+        return NULL;
+    }
+    size_t const n = matrix->rows;
+    struct cholesky_factorization * const factorization = malloc(sizeof(struct cholesky_factorization));
+    if(factorization == NULL) {
+        return NULL;
+    }
+    factorization->n = n;
+    factorization->l = malloc(sizeof(long double) * CHOLESKY_INDEX(n, 0));
+    if(factorization->l == NULL) {
+        free(factorization);
+        return NULL;
+    }
+    long double * const l = factorization->l;
+    /* Only the lower triangle of the input is ever read */
+    for(size_t i = 0; i < n; i++) {
+        for(size_t j = 0; j <= i; j++) {
+            l[CHOLESKY_INDEX(i, j)] = MATRIX_ELEMENT(matrix, i, j);
+        }
+    }
+    char failed = 0;
+    if(n <= CHOLESKY_BLOCK) {
+        failed = cholesky_diagonal_block(l, 0, n);
+    } else {
+        /* Right-looking blocked variant: factor a diagonal block, then solve
+         * the panel below it and update the trailing matrix in parallel */
+        struct cholesky_job job = {
+            l,
+            0,
+            0
+        };
+        for(size_t block = 0; block < n && !failed; block += CHOLESKY_BLOCK) {
+            job.block = block;
+            job.block_end = (n - block < CHOLESKY_BLOCK) ? n : block + CHOLESKY_BLOCK;
+            failed = cholesky_diagonal_block(l, block, job.block_end);
+            if(!failed) {
+                size_t const grain = 1L + REDUCTION_GRAIN / (CHOLESKY_BLOCK * n);
+                parallel_for(n - job.block_end, grain, cholesky_panel_task, &job);
+                parallel_for(n - job.block_end, grain, cholesky_update_task, &job);
+            }
+        }
+    }
+    if(failed) {
+        destroy_cholesky_factorization(factorization);
+        return NULL;
+    }
+    return factorization;
+}
+
+void destroy_cholesky_factorization(struct cholesky_factorization * const factorization)
+{
+    free(factorization->l);
+    free(factorization);
+}
+
+struct cholesky_solve_job {
+    struct cholesky_factorization const* factorization;
+    struct matrix* X;
+};
+
+/* Forward and back substitution for columns [begin, end) of X */
+static void cholesky_solve_task(size_t const begin, size_t const end, void * const arg)
+{
+    struct cholesky_solve_job const * const job = arg;
+    size_t const n = job->factorization->n, cols = job->X->cols;
+    long double const * const l = job->factorization->l;
+    long double * const x = job->X->elements;
+    /* L y = b */
+    for(size_t i = 0; i < n; i++) {
+        long double const * const row_i = l + CHOLESKY_INDEX(i, 0);
+        for(size_t k = 0; k < i; k++) {
+            for(size_t j = begin; j < end; j++) {
+                x[i * cols + j] -= row_i[k] * x[k * cols + j];
+            }
+        }
+        for(size_t j = begin; j < end; j++) {
+            x[i * cols + j] /= row_i[i];
+        }
+    }
+    /* L^T x = y, walking L by rows so the packed storage is read contiguously */
+    for(size_t i = n; i-- != 0;) {
+        long double const * const row_i = l + CHOLESKY_INDEX(i, 0);
+        for(size_t j = begin; j < end; j++) {
+            x[i * cols + j] /= row_i[i];
+        }
+        for(size_t k = 0; k < i; k++) {
+            for(size_t j = begin; j < end; j++) {
+                x[k * cols + j] -= row_i[k] * x[i * cols + j];
+            }
+        }
+    }
+}
+
+struct matrix* cholesky_solve(struct cholesky_factorization const * const factorization, struct matrix const * const B) {
+    size_t const n = factorization->n;
+    if(B->rows != n) {
+        printf("Dimensions mismatch: L: (cols: %ld, rows: %ld), B: (cols: %ld, rows: %ld)\n", n, n, B->cols, B->rows);
+        return NULL;
+    }
+    struct matrix * const X = create_matrix(B->cols, n);
+    if(X != NULL) {
+        for(size_t i = 0; i < n; i++) {
+            for(size_t j = 0; j < B->cols; j++) {
+                X->elements[i * B->cols + j] = MATRIX_ELEMENT(B, i, j);
             }
-            destroy_matrix(temp);
-            return inverse;
-        } else {
-            destroy_matrix(temp);
         }
+        struct cholesky_solve_job job = {
+            factorization,
+            X
+        };
+        parallel_for(B->cols, 1L + REDUCTION_GRAIN / (n * n), cholesky_solve_task, &job);
     }
-    return NULL;
+    return X;
 }
 
 void print_matrix(struct matrix const * const matrix)
@@ -218,7 +768,7 @@ void print_matrix(struct matrix const * const matrix)
     for(size_t i = 0; i < matrix->rows; i++) {
         printf("[ ");
         for(size_t j = 0; j < matrix->cols; j++) {
-            printf("%.3Lf ", matrix->elements[i * matrix->cols + j]);
+            printf("%.3Lf ", MATRIX_ELEMENT(matrix, i, j));
         }
         printf("]\n");
     }
@@ -20,18 +20,62 @@
  THE SOFTWARE.
 */
 
+/* Element (i, j), zero-based, is elements[offset + i * row_stride + j * col_stride].
+ * Matrices from create_matrix() own their (contiguous, row-major) elements.
+ * The matrix_view_*() functions return non-owning views that share the
+ * elements of another matrix or array; they are plain values, must not be
+ * passed to destroy_matrix() and are valid as long as the elements are.
+ * Every routine below accepts views wherever it takes a const matrix. */
 struct matrix {
     long double *elements;
     size_t cols;
     size_t rows;
+    size_t offset;
+    size_t row_stride;
+    size_t col_stride;
+};
+
+#define MATRIX_ELEMENT(matrix, i, j) ((matrix)->elements[(matrix)->offset + (i) * (matrix)->row_stride + (j) * (matrix)->col_stride])
+
+/* PA = LU with partial pivoting. L (unit diagonal, not stored) and U share lu;
+ * row i of lu comes from row pivots[i] of A */
+struct lu_factorization {
+    struct matrix *lu;
+    size_t *pivots;
+};
+
+/* A = L L^T. Only the lower triangle is stored, packed by rows: L[i][j] is
+ * l[i * (i + 1) / 2 + j] */
+struct cholesky_factorization {
+    size_t n;
+    long double *l;
 };
 
 struct matrix* create_matrix(size_t cols, size_t rows);
 void destroy_matrix(struct matrix * const);
+/* Rows and columns of views are one-based, like matrix_set_row(). Out of range
+ * blocks give an empty view (elements == NULL) */
+struct matrix matrix_view_array(long double* elements, size_t cols, size_t rows);
+struct matrix matrix_view_transpose(struct matrix const* matrix);
+struct matrix matrix_view_block(struct matrix const* matrix, size_t row, size_t col, size_t rows, size_t cols);
+struct matrix matrix_view_row(struct matrix const* matrix, size_t row);
+struct matrix matrix_view_col(struct matrix const* matrix, size_t col);
 void matrix_set_row(struct matrix * matrix, size_t row, long double);
 void matrix_set_row_vector(struct matrix *matrix, size_t row, long double const* vector);
 void matrix_set_row_vector_power(struct matrix * matrix, size_t row, long double const* vector, long double power);
 struct matrix* transpose_matrix(struct matrix const* matrix);
 struct matrix* matrix_multiply(struct matrix const* A, struct matrix const* B);
+struct matrix* matrix_multiply_naive(struct matrix const* A, struct matrix const* B);
+/* C (m × n) = A (m × k) * B (k × n), all row-major and contiguous. Returns 0 on success */
+char matrix_multiply_double(size_t m, size_t n, size_t k, double const* A, double const* B, double* C);
+char const* matrix_multiply_double_kernel(void);
 struct matrix* matrix_inverse(struct matrix const *);
+struct lu_factorization* lu_factor(struct matrix const* matrix);
+/* Solves A X = B for every column of B */
+struct matrix* lu_solve(struct lu_factorization const* factorization, struct matrix const* B);
+void destroy_lu_factorization(struct lu_factorization*);
+/* Returns NULL unless the matrix is (numerically) symmetric positive definite */
+struct cholesky_factorization* cholesky_factor(struct matrix const* matrix);
+struct matrix* cholesky_solve(struct cholesky_factorization const* factorization, struct matrix const* B);
+void destroy_cholesky_factorization(struct cholesky_factorization*);
 void print_matrix(struct matrix const * const matrix);
@@ -0,0 +1,178 @@
+/*
+ Copyright (c) 2015 Ricardo Iván Vieitez Parra
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
+#include "precision.h"
+
+/* Independent accumulators per sum (one AVX-512 vector of doubles) */
+#define PRECISION_LANES 8
+/* Points per chunk of precision_accumulate_moments() */
+#define PRECISION_CHUNK 1024
+/* Independent Horner chains in precision_polynomial_values() are set per
+ * type below: a full vector for float and double, and just two for long
+ * double, where more lanes spill out of the x87 register stack. The
+ * barycentric recurrence keeps three values per lane, so long double gets a
+ * single one there. */
+
+#define PRECISION_T float
+#define PRECISION_HORNER_LANES 16
+#define PRECISION_BARYCENTRIC_LANES 16
+#define PRECISION_SUFFIX f
+#include "precision_template.h"
+#undef PRECISION_T
+#undef PRECISION_SUFFIX
+#undef PRECISION_HORNER_LANES
+#undef PRECISION_BARYCENTRIC_LANES
+
+#define PRECISION_T double
+#define PRECISION_HORNER_LANES 8
+#define PRECISION_BARYCENTRIC_LANES 8
+#define PRECISION_SUFFIX d
+#include "precision_template.h"
+#undef PRECISION_T
+#undef PRECISION_SUFFIX
+#undef PRECISION_HORNER_LANES
+#undef PRECISION_BARYCENTRIC_LANES
+
+#define PRECISION_T long double
+#define PRECISION_HORNER_LANES 2
+#define PRECISION_BARYCENTRIC_LANES 1
+#define PRECISION_SUFFIX ld
+#include "precision_template.h"
+#undef PRECISION_T
+#undef PRECISION_SUFFIX
+#undef PRECISION_HORNER_LANES
+#undef PRECISION_BARYCENTRIC_LANES
+
+static char const* const precision_names[] = {
+    "float",
+    "double",
+    "long double"
+};
+
+/* Read from PROJECT1_PRECISION once, before the first get or set. Pool
+ * threads read it concurrently, hence the atomic accesses */
+static int current_precision = PRECISION_LONG_DOUBLE;
+static pthread_once_t precision_once = PTHREAD_ONCE_INIT;
+
+static void init_precision(void)
+{
+    enum precision precision = PRECISION_LONG_DOUBLE;
+    char const * const env = getenv("PROJECT1_PRECISION");
+    if(env != NULL && parse_precision(env, &precision) != 0) {
+        fprintf(stderr, "Ignoring invalid PROJECT1_PRECISION=%s\n", env);
+    }
+    __atomic_store_n(&current_precision, (int)precision, __ATOMIC_RELAXED);
+}
+
+enum precision get_precision(void)
+{
+    pthread_once(&precision_once, init_precision);
+    return (enum precision)__atomic_load_n(&current_precision, __ATOMIC_RELAXED);
+}
+
+void set_precision(enum precision const precision)
+{
+    pthread_once(&precision_once, init_precision);
+    __atomic_store_n(&current_precision, (int)precision, __ATOMIC_RELAXED);
+}
+
+char const* precision_name(enum precision const precision)
+{
+    return precision_names[precision];
+}
+
+char parse_precision(char const * const name, enum precision * const precision)
+{
+    for(size_t i = 0; i != sizeof(precision_names) / sizeof(precision_names[0]); i++) {
+        if(strcmp(name, precision_names[i]) == 0) {
+            *precision = (enum precision)i;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void precision_sum_squares(long double const * const a, long double const * const b, size_t const n, long double * const difference2, long double * const f2)
+{
+    switch(get_precision()) {
+    case PRECISION_FLOAT:
+        sum_squares_f(a, b, n, difference2, f2);
+        break;
+    case PRECISION_DOUBLE:
+        sum_squares_d(a, b, n, difference2, f2);
+        break;
+    default:
+        sum_squares_ld(a, b, n, difference2, f2);
+        break;
+    }
+}
+
+void precision_accumulate_moments(long double const start, long double const interval, size_t const first, size_t const n, long double const * const y, size_t const order, long double * const power_sums, long double * const moments)
+{
+    switch(get_precision()) {
+    case PRECISION_FLOAT:
+        accumulate_moments_f(start, interval, first, n, y, order, power_sums, moments);
+        break;
+    case PRECISION_DOUBLE:
+        accumulate_moments_d(start, interval, first, n, y, order, power_sums, moments);
+        break;
+    default:
+        accumulate_moments_ld(start, interval, first, n, y, order, power_sums, moments);
+        break;
+    }
+}
+
+void precision_polynomial_values(long double const * const coefficients, size_t const order, long double const * const x, long double * const y, size_t const n)
+{
+    switch(get_precision()) {
+    case PRECISION_FLOAT:
+        polynomial_values_f(coefficients, order, x, y, n);
+        break;
+    case PRECISION_DOUBLE:
+        polynomial_values_d(coefficients, order, x, y, n);
+        break;
+    default:
+        polynomial_values_ld(coefficients, order, x, y, n);
+        break;
+    }
+}
+
+void precision_barycentric_values(long double const * const nodes, long double const * const weights, long double const * const samples, size_t const n_nodes, long double const * const x, long double * const y, size_t const n)
+{
+    switch(get_precision()) {
+    case PRECISION_FLOAT:
+        barycentric_values_f(nodes, weights, samples, n_nodes, x, y, n);
+        break;
+    case PRECISION_DOUBLE:
+        barycentric_values_d(nodes, weights, samples, n_nodes, x, y, n);
+        break;
+    default:
+        barycentric_values_ld(nodes, weights, samples, n_nodes, x, y, n);
+        break;
+    }
+}
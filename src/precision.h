@@ -0,0 +1,60 @@
+/*
+ Copyright (c) 2015 Ricardo Iván Vieitez Parra
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+
+/* Element type used by the numeric hot paths (matrix products, least squares
+ * accumulation, error sums and batch polynomial evaluation). Values still enter and leave the core as
+ * long double; with float or double the kernels convert once and run in the
+ * narrower type, which the compiler can vectorise.
+ *
+ * The default is long double, or PROJECT1_PRECISION (float, double or
+ * long double) if it is set. */
+
+enum precision {
+    PRECISION_FLOAT,
+    PRECISION_DOUBLE,
+    PRECISION_LONG_DOUBLE
+};
+
+enum precision get_precision(void);
+void set_precision(enum precision);
+char const* precision_name(enum precision);
+/* Returns 0 and stores the precision if name is valid, 1 otherwise */
+char parse_precision(char const* name, enum precision* precision);
+
+/* Σ (a[i] - b[i])² and Σ a[i]², added to *difference2 and *f2 */
+void precision_sum_squares(long double const* a, long double const* b, size_t n, long double* difference2, long double* f2);
+/* For the n points x = start + interval * (first + i) with values y[i], adds
+ * Σ x**m to power_sums[m] (m <= 2 * order) and Σ y x**m to moments[m] (m <= order) */
+void precision_accumulate_moments(long double start, long double interval, size_t first, size_t n, long double const* y, size_t order, long double* power_sums, long double* moments);
+/* Above this order polynomials are evaluated as even + x * odd, two Horner
+ * chains in x**2, rather than by plain Horner's rule */
+#define POLYNOMIAL_ESTRIN_ORDER 8L
+
+/* y[i] = Σ coefficients[k] x[i]**k for k <= order, the same way polynomial_value() does */
+void precision_polynomial_values(long double const* coefficients, size_t order, long double const* x, long double* y, size_t n);
+/* Nodes between the rescalings of the barycentric recurrence */
+#define BARYCENTRIC_RESCALE_NODES 16L
+
+/* y[i] = the barycentric interpolant through (nodes[j], samples[j]), j < n_nodes,
+ * with the given weights, at x[i], the same way barycentric_value() does */
+void precision_barycentric_values(long double const* nodes, long double const* weights, long double const* samples, size_t n_nodes, long double const* x, long double* y, size_t n);
@@ -0,0 +1,197 @@
+/*
+ Copyright (c) 2015 Ricardo Iván Vieitez Parra
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+
+/* Kernels behind precision.h. This file is a template: precision.c includes
+ * it once per element type after defining PRECISION_T and PRECISION_SUFFIX.
+ *
+ * Sums are kept in PRECISION_LANES independent accumulators, combined in a
+ * fixed order at the end. That lets the compiler vectorise the loops without
+ * reassociating anything, so results stay reproducible. */
+
+#define PRECISION_CONCAT2(a, b) a##_##b
+#define PRECISION_CONCAT(a, b) PRECISION_CONCAT2(a, b)
+#define PRECISION_NAME(name) PRECISION_CONCAT(name, PRECISION_SUFFIX)
+
+static void PRECISION_NAME(sum_squares)(long double const * const a, long double const * const b, size_t const n, long double * const difference2, long double * const f2)
+{
+    PRECISION_T d_acc[PRECISION_LANES] = {0}, f_acc[PRECISION_LANES] = {0};
+    PRECISION_T ta[PRECISION_LANES], tb[PRECISION_LANES];
+    size_t i = 0;
+    for(; i + PRECISION_LANES <= n; i += PRECISION_LANES) {
+        for(size_t l = 0; l < PRECISION_LANES; l++) {
+            ta[l] = (PRECISION_T)a[i + l];
+            tb[l] = (PRECISION_T)b[i + l];
+        }
+        for(size_t l = 0; l < PRECISION_LANES; l++) {
+            PRECISION_T const d = ta[l] - tb[l];
+            d_acc[l] += d * d;
+            f_acc[l] += ta[l] * ta[l];
+        }
+    }
+    for(size_t l = 0; i < n; i++, l++) {
+        PRECISION_T const fa = (PRECISION_T)a[i], d = fa - (PRECISION_T)b[i];
+        d_acc[l] += d * d;
+        f_acc[l] += fa * fa;
+    }
+    long double d_sum = 0.0L, f_sum = 0.0L;
+    for(size_t l = 0; l < PRECISION_LANES; l++) {
+        d_sum += d_acc[l];
+        f_sum += f_acc[l];
+    }
+    *difference2 += d_sum;
+    *f2 += f_sum;
+}
+
+static void PRECISION_NAME(accumulate_moments)(long double const start, long double const interval, size_t const first, size_t const n, long double const * const y, size_t const order, long double * const power_sums, long double * const moments)
+{
+    PRECISION_T x[PRECISION_CHUNK], p[PRECISION_CHUNK], py[PRECISION_CHUNK];
+    for(size_t c = 0; c < n; c += PRECISION_CHUNK) {
+        size_t const m = (n - c < PRECISION_CHUNK) ? n - c : PRECISION_CHUNK;
+        /* Pad the chunk to whole lanes with zero weight */
+        size_t const padded = ((m + PRECISION_LANES - 1) / PRECISION_LANES) * PRECISION_LANES;
+        for(size_t i = 0; i < padded; i++) {
+            if(i < m) {
+                x[i] = (PRECISION_T)(start + interval * (long double)(first + c + i));
+                p[i] = 1;
+                py[i] = (PRECISION_T)y[c + i];
+            } else {
+                x[i] = p[i] = py[i] = 0;
+            }
+        }
+        for(size_t j = 0; j <= 2L * order; j++) {
+            PRECISION_T p_acc[PRECISION_LANES] = {0}, y_acc[PRECISION_LANES] = {0};
+            for(size_t i = 0; i < padded; i += PRECISION_LANES) {
+                for(size_t l = 0; l < PRECISION_LANES; l++) {
+                    p_acc[l] += p[i + l];
+                    y_acc[l] += py[i + l];
+                    p[i + l] *= x[i + l];
+                    py[i + l] *= x[i + l];
+                }
+            }
+            long double p_sum = 0.0L, y_sum = 0.0L;
+            for(size_t l = 0; l < PRECISION_LANES; l++) {
+                p_sum += p_acc[l];
+                y_sum += y_acc[l];
+            }
+            power_sums[j] += p_sum;
+            if(j <= order) {
+                moments[j] += y_sum;
+            }
+        }
+    }
+}
+
+/* Horner's rule, or above POLYNOMIAL_ESTRIN_ORDER its even/odd split in x**2,
+ * on PRECISION_HORNER_LANES points at a time, so each step is one
+ * multiply-add across independent lanes held in registers */
+static void PRECISION_NAME(polynomial_values)(long double const * const coefficients, size_t const order, long double const * const x, long double * const y, size_t const n)
+{
+    PRECISION_T tx[PRECISION_HORNER_LANES], ty[PRECISION_HORNER_LANES];
+    PRECISION_T tx2[PRECISION_HORNER_LANES], todd[PRECISION_HORNER_LANES];
+    size_t const even_top = order & ~(size_t)1, odd_top = (order & 1) ? order : order - 1;
+    for(size_t i = 0; i < n; i += PRECISION_HORNER_LANES) {
+        size_t const m = (n - i < PRECISION_HORNER_LANES) ? n - i : PRECISION_HORNER_LANES;
+        for(size_t l = 0; l < PRECISION_HORNER_LANES; l++) {
+            tx[l] = (l < m) ? (PRECISION_T)x[i + l] : 0;
+        }
+        if(order <= POLYNOMIAL_ESTRIN_ORDER) {
+            for(size_t l = 0; l < PRECISION_HORNER_LANES; l++) {
+                ty[l] = (PRECISION_T)coefficients[order];
+            }
+            for(size_t k = order; k != 0; k--) {
+                PRECISION_T const ck = (PRECISION_T)coefficients[k - 1];
+                for(size_t l = 0; l < PRECISION_HORNER_LANES; l++) {
+                    ty[l] = ty[l] * tx[l] + ck;
+                }
+            }
+        } else {
+            for(size_t l = 0; l < PRECISION_HORNER_LANES; l++) {
+                tx2[l] = tx[l] * tx[l];
+                ty[l] = (PRECISION_T)coefficients[even_top];
+                todd[l] = (PRECISION_T)coefficients[odd_top];
+            }
+            for(size_t k = even_top; k >= 2; k -= 2) {
+                PRECISION_T const ck = (PRECISION_T)coefficients[k - 2];
+                for(size_t l = 0; l < PRECISION_HORNER_LANES; l++) {
+                    ty[l] = ty[l] * tx2[l] + ck;
+                }
+            }
+            for(size_t k = odd_top; k >= 3; k -= 2) {
+                PRECISION_T const ck = (PRECISION_T)coefficients[k - 2];
+                for(size_t l = 0; l < PRECISION_HORNER_LANES; l++) {
+                    todd[l] = todd[l] * tx2[l] + ck;
+                }
+            }
+            for(size_t l = 0; l < PRECISION_HORNER_LANES; l++) {
+                ty[l] = ty[l] + tx[l] * todd[l];
+            }
+        }
+        for(size_t l = 0; l < m; l++) {
+            y[i + l] = ty[l];
+        }
+    }
+}
+
+/* The recurrence of barycentric_value() on PRECISION_BARYCENTRIC_LANES points at a
+ * time, so each node is read once per block and the lanes are independent */
+static void PRECISION_NAME(barycentric_values)(long double const * const nodes, long double const * const weights, long double const * const samples, size_t const n_nodes, long double const * const x, long double * const y, size_t const n)
+{
+    PRECISION_T tx[PRECISION_BARYCENTRIC_LANES], numerator[PRECISION_BARYCENTRIC_LANES], denominator[PRECISION_BARYCENTRIC_LANES], product[PRECISION_BARYCENTRIC_LANES];
+    /* Node a lane sits exactly on, n_nodes if none */
+    size_t at_node[PRECISION_BARYCENTRIC_LANES];
+    for(size_t i = 0; i < n; i += PRECISION_BARYCENTRIC_LANES) {
+        size_t const m = (n - i < PRECISION_BARYCENTRIC_LANES) ? n - i : PRECISION_BARYCENTRIC_LANES;
+        for(size_t l = 0; l < PRECISION_BARYCENTRIC_LANES; l++) {
+            tx[l] = (PRECISION_T)x[(l < m) ? i + l : i];
+            numerator[l] = denominator[l] = 0;
+            product[l] = 1;
+            at_node[l] = n_nodes;
+        }
+        for(size_t j = 0; j != n_nodes; j++) {
+            PRECISION_T const node = (PRECISION_T)nodes[j], weight = (PRECISION_T)weights[j], sample = (PRECISION_T)samples[j];
+            for(size_t l = 0; l < PRECISION_BARYCENTRIC_LANES; l++) {
+                PRECISION_T const d = tx[l] - node;
+                PRECISION_T const t = weight * product[l];
+                numerator[l] = numerator[l] * d + t * sample;
+                denominator[l] = denominator[l] * d + t;
+                product[l] *= d;
+                at_node[l] = (d == 0) ? j : at_node[l];
+            }
+            if((j + 1) % BARYCENTRIC_RESCALE_NODES == 0) {
+                for(size_t l = 0; l < PRECISION_BARYCENTRIC_LANES; l++) {
+                    PRECISION_T const scale = (product[l] != 0) ? 1 / product[l] : 1;
+                    numerator[l] *= scale;
+                    denominator[l] *= scale;
+                    product[l] *= scale;
+                }
+            }
+        }
+        for(size_t l = 0; l < m; l++) {
+            y[i + l] = (at_node[l] != n_nodes) ? samples[at_node[l]] : (long double)(numerator[l] / denominator[l]);
+        }
+    }
+}
+
+#undef PRECISION_NAME
+#undef PRECISION_CONCAT
+#undef PRECISION_CONCAT2
@@ -24,18 +24,31 @@
 #include <stdio.h>
 #include <math.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <float.h>
+#include <limits.h>
 #include "utilities.h"
+#include "precision.h"
+#include "thread_pool.h"
 #include "project1.h"
 
 #define LEAST_SQUARES_POINTS 524288.0L
 #define SQUARE_ROOT_TOLERANCE 1E-7L
+/* Points evaluated at a time by streaming_least_squares_interpolation() */
+#define LEAST_SQUARES_CHUNK 1024L
+/* Scan steps evaluated at a time by find_roots() */
+#define ROOT_SCAN_CHUNK 1024L
+/* Square roots computed at a time by square_root_values() */
+#define SQUARE_ROOT_CHUNK 1024L
+
+#ifndef M_PI
+#define M_PI 3.1415926535897932384626433832795028841971L
+#endif
 
 struct result bisection_method(struct function const* function, long double x0, long double x1, long double tolerance) {
-    struct result result;
-    result.iterations = 0L;
+    struct result result = {NAN, NAN, 0L, 0};
     if(x0 >= x1) {
-        result.value = NAN;
-        result.error = NAN;
         return result;
     }
 
@@ -83,9 +96,471 @@ struct result bisection_method(struct function const* function, long double x0,
     return result;
 }
 
+/* bisection_method() on n brackets at once. Every step evaluates the
+ * midpoints of all the brackets still active with a single batch call, and
+ * brackets leave the batch as they converge. Each result is the same as
+ * bisection_method() would give for that bracket. Returns a malloc'd array
+ * of n results, or NULL if out of memory. */
+struct result* multi_bisection_method(struct function const* const function, long double const* const x0, long double const* const x1, size_t const n, long double const tolerance) {
+    struct result * const results = malloc(sizeof(struct result) * n);
+    long double * const state = malloc(sizeof(long double) * n * 8);
+    size_t * const active = malloc(sizeof(size_t) * n);
+    if(results == NULL || state == NULL || active == NULL) {
+        fprintf(stderr, "multi_bisection_method(): Unable to allocate memory.\n");
+        free(results);
+        free(state);
+        free(active);
+        return NULL;
+    }
+    long double * const lo = state, * const hi = state + n, * const y_lo = state + 2 * n, * const y_hi = state + 3 * n;
+    /* Room for both ends of every bracket on the first evaluation */
+    long double * const x = state + 4 * n, * const y = state + 6 * n;
+    size_t n_active = 0;
+
+    /* Tolerence is halved because it is compared to the error in +/- form, also halved */
+    long double const half_tolerance = tolerance / 2.0L;
+
+    for(size_t i = 0; i != n; i++) {
+        results[i].iterations = 0L;
+        results[i].convergence_rate = 0;
+        results[i].evaluations = 0L;
+        results[i].time = 0.0L;
+        if(x0[i] >= x1[i]) {
+            results[i].value = NAN;
+            results[i].error = NAN;
+            continue;
+        }
+        lo[i] = x0[i];
+        hi[i] = x1[i];
+        x[n_active] = x0[i];
+        x[n_active + 1] = x1[i];
+        active[n_active / 2] = i;
+        n_active += 2;
+    }
+    /* Both ends of every valid bracket in one call, then unpack */
+    if(n_active != 0) {
+        function_values(function, x, y, n_active);
+    }
+    for(size_t a = 0; a != n_active / 2; a++) {
+        size_t const i = active[a];
+        y_lo[i] = y[2 * a];
+        y_hi[i] = y[2 * a + 1];
+    }
+    size_t const n_valid = n_active / 2;
+    n_active = 0;
+    for(size_t a = 0; a != n_valid; a++) {
+        size_t const i = active[a];
+        results[i].error = (hi[i] - lo[i]) / 2.0L;
+        results[i].value = (lo[i] + hi[i]) / 2.0L;
+        if(y_lo[i] * y_hi[i] > 0) {
+            results[i].value = NAN;
+            results[i].error = NAN;
+            continue;
+        }
+        results[i].convergence_rate = 1;
+        if(results[i].error > half_tolerance) {
+            active[n_active++] = i;
+        }
+    }
+
+    while(n_active != 0) {
+        size_t n_evaluate = 0;
+        for(size_t a = 0; a != n_active; a++) {
+            size_t const i = active[a];
+            results[i].error /= 2.0L;
+            results[i].iterations++;
+            if(y_lo[i] == 0.0L) {
+                results[i].error = 0.0L;
+                results[i].value = lo[i];
+            } else if(y_hi[i] == 0.0L) {
+                results[i].error = 0.0L;
+                results[i].value = hi[i];
+            } else {
+                x[n_evaluate] = results[i].value;
+                active[n_evaluate++] = i;
+            }
+        }
+        function_values(function, x, y, n_evaluate);
+        n_active = 0;
+        for(size_t a = 0; a != n_evaluate; a++) {
+            size_t const i = active[a];
+            if(y_lo[i] * y[a] < 0.0L) {
+                hi[i] = results[i].value;
+                y_hi[i] = y[a];
+            } else {
+                lo[i] = results[i].value;
+                y_lo[i] = y[a];
+            }
+            results[i].value = (lo[i] + hi[i]) / 2.0L;
+            if(results[i].error > half_tolerance) {
+                active[n_active++] = i;
+            }
+        }
+    }
+
+    free(state);
+    free(active);
+    return results;
+}
+
+/* Order of convergence estimated from the last three errors, at least 1 and
+ * at most UCHAR_MAX; 0 when they do not give a finite estimate */
+static unsigned char convergence_rate_estimate(long double const * const errors)
+{
+    long double const rate = roundl(logl(errors[2] / errors[1]) / logl(errors[1] / errors[0]));
+    if(!isfinite(rate)) {
+        return 0;
+    }
+    return (rate < 1.0L) ? 1 : ((rate > UCHAR_MAX) ? UCHAR_MAX : (unsigned char)rate);
+}
+
+/* Brent-Dekker: inverse quadratic interpolation or secant steps, falling
+ * back to bisection whenever they would not shrink the bracket fast enough.
+ * Stops on the same bracket width as bisection_method(). */
+struct result brent_method(struct function const* const function, long double x0, long double x1, long double const tolerance) {
+    long double errors[] = {0.0L, 0.0L, 0.0L};
+    struct result result = {NAN, NAN, 0L, 1};
+    if(x0 >= x1) {
+        return result;
+    }
+
+    long double a = x0, b = x1, c = x1;
+    long double fa = function->f(a, function->arg), fb = function->f(b, function->arg), fc = fb;
+    long double d = b - a, e = d;
+
+    if(fa * fb > 0) {
+        return result;
+    }
+
+    for(;;) {
+        if((fb > 0.0L && fc > 0.0L) || (fb < 0.0L && fc < 0.0L)) {
+            c = a;
+            fc = fa;
+            d = e = b - a;
+        }
+        if(fabsl(fc) < fabsl(fb)) {
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+        long double const tolerance1 = 2.0L * LDBL_EPSILON * fabsl(b) + tolerance / 2.0L;
+        long double const half = (c - b) / 2.0L;
+        if(fb == 0.0L) {
+            result.error = 0.0L;
+            break;
+        }
+        if(fabsl(half) <= tolerance1) {
+            result.error = fabsl(half);
+            break;
+        }
+        if(fabsl(e) >= tolerance1 && fabsl(fa) > fabsl(fb)) {
+            long double const s = fb / fa;
+            long double p, q;
+            if(a == c) {
+                p = 2.0L * half * s;
+                q = 1.0L - s;
+            } else {
+                long double const r = fb / fc;
+                q = fa / fc;
+                p = s * (2.0L * half * q * (q - r) - (b - a) * (r - 1.0L));
+                q = (q - 1.0L) * (r - 1.0L) * (s - 1.0L);
+            }
+            if(p > 0.0L) {
+                q = -q;
+            }
+            p = fabsl(p);
+            long double const min1 = 3.0L * half * q - fabsl(tolerance1 * q);
+            long double const min2 = fabsl(e * q);
+            if(2.0L * p < ((min1 < min2) ? min1 : min2)) {
+                e = d;
+                d = p / q;
+            } else {
+                d = e = half;
+            }
+        } else {
+            d = e = half;
+        }
+        a = b;
+        fa = fb;
+        b += (fabsl(d) > tolerance1) ? d : copysignl(tolerance1, half);
+        fb = function->f(b, function->arg);
+        result.iterations++;
+        errors[0] = errors[1];
+        errors[1] = errors[2];
+        errors[2] = fabsl(b - a);
+    }
+    result.value = b;
+    if(result.iterations >= 3) {
+        unsigned char const rate = convergence_rate_estimate(errors);
+        if(rate != 0) {
+            result.convergence_rate = rate;
+        }
+    }
+    return result;
+}
+
+/* Regula falsi with the Illinois modification: the function value kept at an
+ * end that survives twice in a row is halved, so both ends keep moving. */
+struct result illinois_method(struct function const* const function, long double x0, long double x1, long double const tolerance) {
+    long double errors[] = {0.0L, 0.0L, 0.0L};
+    struct result result = {NAN, NAN, 0L, 1};
+    if(x0 >= x1) {
+        return result;
+    }
+
+    long double y0 = function->f(x0, function->arg);
+    long double y1 = function->f(x1, function->arg);
+
+    if(y0 * y1 > 0) {
+        return result;
+    }
+    if(y0 == 0.0L || y1 == 0.0L) {
+        result.value = (y0 == 0.0L) ? x0 : x1;
+        result.error = 0.0L;
+        return result;
+    }
+    result.error = (x1 - x0) / 2.0L;
+    result.value = (x0 + x1) / 2.0L;
+
+    /* -1 or 1 when the same end was kept in the last step */
+    int side = 0;
+    long double last = NAN;
+    while(result.error > 2.0L * LDBL_EPSILON * fabsl(result.value) + tolerance / 2.0L) {
+        long double xm = x1 - y1 * (x1 - x0) / (y1 - y0);
+        if(!(xm > x0 && xm < x1)) {
+            xm = (x0 + x1) / 2.0L;
+        }
+        long double const ym = function->f(xm, function->arg);
+        result.iterations++;
+        errors[0] = errors[1];
+        errors[1] = errors[2];
+        errors[2] = fabsl(xm - last);
+        last = xm;
+        if(ym == 0.0L) {
+            result.value = xm;
+            result.error = 0.0L;
+            return result;
+        }
+        if(y0 * ym < 0.0L) {
+            x1 = xm;
+            y1 = ym;
+            if(side == -1) {
+                y0 /= 2.0L;
+            }
+            side = -1;
+        } else {
+            x0 = xm;
+            y0 = ym;
+            if(side == 1) {
+                y1 /= 2.0L;
+            }
+            side = 1;
+        }
+        result.error = (x1 - x0) / 2.0L;
+        result.value = (x0 + x1) / 2.0L;
+    }
+    if(result.iterations >= 3) {
+        unsigned char const rate = convergence_rate_estimate(errors);
+        if(rate != 0) {
+            result.convergence_rate = rate;
+        }
+    }
+    return result;
+}
+
+struct root_bracket {
+    long double lower;
+    long double upper;
+};
+
+/* Brackets found by one chunk of the scan, in increasing order */
+struct root_scan_part {
+    struct root_bracket* brackets;
+    size_t count;
+    size_t capacity;
+    int failed;
+};
+
+struct root_scan_job {
+    struct function const* function;
+    struct function const* derivative;
+    long double start;
+    long double end;
+    size_t steps;
+    long double tolerance;
+    struct root_scan_part* parts;
+};
+
+static void root_scan_add(struct root_scan_part* const part, long double const lower, long double const upper)
+{
+    if(part->failed) {
+        return;
+    }
+    if(part->count == part->capacity) {
+        size_t const capacity = (part->capacity == 0) ? 4 : 2 * part->capacity;
+        struct root_bracket * const brackets = realloc(part->brackets, sizeof(struct root_bracket) * capacity);
+        if(brackets == NULL) {
+            part->failed = 1;
+            return;
+        }
+        part->brackets = brackets;
+        part->capacity = capacity;
+    }
+    part->brackets[part->count].lower = lower;
+    part->brackets[part->count].upper = upper;
+    part->count++;
+}
+
+static long double root_scan_point(struct root_scan_job const* const job, size_t const i)
+{
+    return (i == job->steps) ? job->end : job->start + (job->end - job->start) * (long double)i / (long double)job->steps;
+}
+
+static void root_scan_task(size_t const begin, size_t const end, void* const arg)
+{
+    struct root_scan_job const* const job = arg;
+    struct root_scan_part* const part = &job->parts[begin / ROOT_SCAN_CHUNK];
+    size_t const n = end - begin + 1;
+    long double x[ROOT_SCAN_CHUNK + 1], y[ROOT_SCAN_CHUNK + 1], dy[ROOT_SCAN_CHUNK + 1];
+
+    x[0] = root_scan_point(job, begin);
+    for(size_t j = 1; j != n; j++) {
+        x[j] = root_scan_point(job, begin + j);
+    }
+    function_values(job->function, x, y, n);
+    if(job->derivative != NULL) {
+        function_values(job->derivative, x, dy, n);
+    }
+
+    for(size_t j = 0; j != n - 1; j++) {
+        /* A zero on the grid belongs to the step it starts */
+        if(y[j] == 0.0L) {
+            root_scan_add(part, x[j], x[j]);
+        } else if(y[j] * y[j + 1] < 0.0L) {
+            root_scan_add(part, x[j], x[j + 1]);
+        } else if(job->derivative != NULL && y[j + 1] != 0.0L && dy[j] * dy[j + 1] < 0.0L) {
+            /* No sign change, but an extremum inside the step may hide a pair of roots */
+            struct result const extremum = brent_method(job->derivative, x[j], x[j + 1], job->tolerance);
+            long double const y_extremum = job->function->f(extremum.value, job->function->arg);
+            if(y_extremum == 0.0L) {
+                root_scan_add(part, extremum.value, extremum.value);
+            } else if(y[j] * y_extremum < 0.0L) {
+                root_scan_add(part, x[j], extremum.value);
+                root_scan_add(part, extremum.value, x[j + 1]);
+            }
+        }
+    }
+    if(end == job->steps && y[n - 1] == 0.0L) {
+        root_scan_add(part, x[n - 1], x[n - 1]);
+    }
+}
+
+struct root_refine_job {
+    struct function const* function;
+    struct root_bracket const* brackets;
+    long double tolerance;
+    struct result* results;
+};
+
+static void root_refine_task(size_t const begin, size_t const end, void* const arg)
+{
+    struct root_refine_job const* const job = arg;
+    for(size_t i = begin; i != end; i++) {
+        if(job->brackets[i].lower == job->brackets[i].upper) {
+            job->results[i].value = job->brackets[i].lower;
+            job->results[i].error = 0.0L;
+            job->results[i].iterations = 0L;
+            job->results[i].convergence_rate = 1;
+            job->results[i].evaluations = 0L;
+            job->results[i].time = 0.0L;
+        } else {
+            job->results[i] = brent_method(job->function, job->brackets[i].lower, job->brackets[i].upper, job->tolerance);
+        }
+    }
+}
+
+/* Finds the roots of function in [start, end]: the interval is scanned in
+ * steps equal parts for sign changes, in parallel, and every bracket found
+ * is then refined with brent_method(), also in parallel. If derivative is not
+ * NULL, steps without a sign change whose derivative changes sign are split
+ * at the extremum, which finds pairs of roots closer than a step.
+ * Roots of even multiplicity are only found if they fall on the grid.
+ * Returns a malloc'd array of *count results in increasing order, or NULL
+ * with *count = 0 if there are no roots or on error. */
+struct result* find_roots(struct function const* const function, struct function const* const derivative, long double const start, long double const end, size_t const steps, long double const tolerance, size_t* const count) {
+    *count = 0;
+    if(end <= start || steps == 0) {
+        return NULL;
+    }
+    size_t const n_parts = (steps + ROOT_SCAN_CHUNK - 1) / ROOT_SCAN_CHUNK;
+    struct root_scan_part * const parts = calloc(n_parts, sizeof(struct root_scan_part));
+    struct root_bracket* brackets = NULL;
+    struct result* results = NULL;
+    if(parts == NULL) {
+        fprintf(stderr, "find_roots(): Unable to allocate memory.\n");
+        return NULL;
+    }
+    struct root_scan_job scan = {
+        function,
+        derivative,
+        start,
+        end,
+        steps,
+        tolerance,
+        parts
+    };
+    parallel_for(steps, ROOT_SCAN_CHUNK, root_scan_task, &scan);
+
+    size_t n = 0;
+    for(size_t i = 0; i != n_parts; i++) {
+        if(parts[i].failed) {
+            fprintf(stderr, "find_roots(): Unable to allocate memory.\n");
+            goto cleanup;
+        }
+        n += parts[i].count;
+    }
+    if(n == 0) {
+        goto cleanup;
+    }
+    brackets = malloc(sizeof(struct root_bracket) * n);
+    results = malloc(sizeof(struct result) * n);
+    if(brackets == NULL || results == NULL) {
+        fprintf(stderr, "find_roots(): Unable to allocate memory.\n");
+        free(results);
+        results = NULL;
+        goto cleanup;
+    }
+    n = 0;
+    for(size_t i = 0; i != n_parts; i++) {
+        for(size_t j = 0; j != parts[i].count; j++) {
+            brackets[n++] = parts[i].brackets[j];
+        }
+    }
+
+    struct root_refine_job refine = {
+        function,
+        brackets,
+        tolerance,
+        results
+    };
+    parallel_for(n, 1, root_refine_task, &refine);
+    *count = n;
+
+cleanup:
+    for(size_t i = 0; i != n_parts; i++) {
+        free(parts[i].brackets);
+    }
+    free(parts);
+    free(brackets);
+    return results;
+}
+
 struct result newtons_method(struct function const* function, struct function const* derivative, long double x0, unsigned long max_iterations, long double tolerance) {
     long double errors[] = {0.0L, 0.0L, 0.0L};
-    struct result result;
+    struct result result = {NAN, NAN, 0L, 0};
 
     for(result.iterations = 0L; result.iterations != max_iterations; result.iterations++) {
         result.value = x0 - function->f(x0, function->arg) / derivative->f(x0, derivative->arg);
@@ -102,9 +577,41 @@ struct result newtons_method(struct function const* function, struct function co
     return result;
 }
 
+/* Newton's method with the derivative replaced by the slope through the
+ * last two iterates; x0 and x1 are the first two iterates. */
+struct result secant_method(struct function const* const function, long double x0, long double x1, unsigned long const max_iterations, long double const tolerance) {
+    long double errors[] = {0.0L, 0.0L, 0.0L};
+    struct result result = {NAN, NAN, 0L, 0};
+    long double y0 = function->f(x0, function->arg);
+    long double y1 = function->f(x1, function->arg);
+
+    result.value = x1;
+    result.error = NAN;
+    for(result.iterations = 0L; result.iterations != max_iterations; result.iterations++) {
+        if(y1 == y0) {
+            result.error = (y1 == 0.0L) ? 0.0L : NAN;
+            break;
+        }
+        result.value = x1 - y1 * (x1 - x0) / (y1 - y0);
+        if((result.error = fabsl((result.value - x1) / result.value)) < tolerance) {
+            break;
+        }
+        errors[0] = errors[1];
+        errors[1] = errors[2];
+        errors[2] = result.error;
+        x0 = x1;
+        y0 = y1;
+        x1 = result.value;
+        y1 = function->f(x1, function->arg);
+    }
+    result.error /= 2.0L;
+    result.convergence_rate = (result.iterations < 3) ? 0 : convergence_rate_estimate(errors);
+    return result;
+}
+
 struct result altered_newtons_method(struct function const* const function, struct function const* const derivative, struct function const* const secondderivative, long double x0,  unsigned long const max_iterations, long double const tolerance) {
     long double errors[] = {0.0L, 0.0L, 0.0L};
-    struct result result;
+    struct result result = {NAN, NAN, 0L, 0};
     double long temp_f, temp_fd, temp_fdd;
     for(result.iterations = 0L; result.iterations != max_iterations; result.iterations++) {
         temp_f = function->f(x0, function->arg);
@@ -198,6 +705,117 @@ struct interpolation const* lagrange_interpolation(struct function const *const
     return lagrange;
 }
 
+/* Weights are closed-form, O(order): (-1)**j binomial(order, j) for uniform
+ * nodes and (-1)**j, halved at both ends, for Chebyshev points. The
+ * interpolant does not change under a common factor, so uniform weights are
+ * divided by the middle binomial to keep them in range in float. */
+struct interpolation const* barycentric_lagrange_interpolation(struct function const *const function, long double const x0, long double const x1, unsigned long const order, enum interpolation_nodes const node_distribution) {
+    if(x0 >= x1) {
+        return NULL;
+    }
+    struct interpolation * const barycentric = allocate_interpolation(function, x0, x1, order);
+    if(barycentric == NULL) {
+        fprintf(stderr, "barycentric_lagrange_interpolation(): Unable to allocate memory.\n");
+        return NULL;
+    }
+    long double * const nodes = barycentric->nodes = malloc(sizeof(long double) * (order + 1));
+    long double * const weights = barycentric->weights = malloc(sizeof(long double) * (order + 1));
+    if(nodes == NULL || weights == NULL) {
+        fprintf(stderr, "barycentric_lagrange_interpolation(): Unable to allocate memory.\n");
+        destroy_interpolation(barycentric);
+        return NULL;
+    }
+
+    if(function->name != NULL) {
+        size_t const len = strlen(function->name) + 80L;
+        barycentric->name = malloc(len * sizeof(char));
+        if(barycentric->name != NULL) {
+            snprintf(barycentric->name, len, "Barycentric Lagrange Interpolation of %s (order %ld%s)", function->name, order, node_distribution == INTERPOLATION_NODES_CHEBYSHEV ? ", Chebyshev nodes" : "");
+        }
+    }
+
+    barycentric->sampling_interval = (order == 0) ? x1 - x0 : (x1 - x0) / ((long double)order);
+    if(order == 0) {
+        nodes[0] = 0.5L * (x0 + x1);
+        weights[0] = 1.0L;
+    } else if(node_distribution == INTERPOLATION_NODES_CHEBYSHEV) {
+        long double const middle = 0.5L * (x0 + x1), half = 0.5L * (x1 - x0);
+        for(size_t j = 0; j <= order; j++) {
+            nodes[j] = middle - half * cosl(M_PI * (long double)j / (long double)order);
+            weights[j] = (j % 2 == 0) ? 1.0L : -1.0L;
+        }
+        weights[0] *= 0.5L;
+        weights[order] *= 0.5L;
+    } else {
+        weights[0] = 1.0L;
+        for(size_t j = 0; j <= order; j++) {
+            nodes[j] = (j == order) ? x1 : x0 + barycentric->sampling_interval * (long double)j;
+            if(j != 0) {
+                weights[j] = -weights[j - 1] * (long double)(order - j + 1) / (long double)j;
+            }
+        }
+        long double const largest = fabsl(weights[order / 2]);
+        for(size_t j = 0; j <= order; j++) {
+            weights[j] /= largest;
+        }
+    }
+    function_values(function, nodes, barycentric->coefficients, order + 1);
+
+    return barycentric;
+}
+
+/* Samples at the order + 1 Chebyshev points of the first kind and takes
+ * their DCT-II: c_j = 2 / n Σ_k f(x_k) cos(pi j (k + 1/2) / n), with c_0
+ * halved. The cosines all come from one table of cos(pi m / (2 n)), m < 4 n */
+struct interpolation const* chebyshev_interpolation(struct function const *const function, long double const x0, long double const x1, unsigned long const order) {
+    if(x0 >= x1) {
+        return NULL;
+    }
+    size_t const n = order + 1;
+    struct interpolation * const chebyshev = allocate_interpolation(function, x0, x1, order);
+    if(chebyshev == NULL) {
+        fprintf(stderr, "chebyshev_interpolation(): Unable to allocate memory.\n");
+        return NULL;
+    }
+    /* samples, nodes and 4 n cosines */
+    long double * const samples = malloc(sizeof(long double) * n * 6);
+    if(samples == NULL) {
+        fprintf(stderr, "chebyshev_interpolation(): Unable to allocate memory.\n");
+        destroy_interpolation(chebyshev);
+        return NULL;
+    }
+    long double * const nodes = samples + n;
+    long double * const cosines = samples + 2 * n;
+
+    if(function->name != NULL) {
+        size_t const len = strlen(function->name) + 50L;
+        chebyshev->name = malloc(len * sizeof(char));
+        if(chebyshev->name != NULL) {
+            snprintf(chebyshev->name, len, "Chebyshev Interpolation of %s (order %ld)", function->name, order);
+        }
+    }
+
+    for(size_t m = 0; m != 4 * n; m++) {
+        cosines[m] = cosl(M_PI * (long double)m / (long double)(2 * n));
+    }
+    long double const middle = 0.5L * (x0 + x1), half = 0.5L * (x1 - x0);
+    for(size_t k = 0; k != n; k++) {
+        nodes[k] = middle + half * cosines[2 * k + 1];
+    }
+    function_values(function, nodes, samples, n);
+    for(size_t j = 0; j != n; j++) {
+        long double c = 0.0L;
+        for(size_t k = 0; k != n; k++) {
+            c += samples[k] * cosines[(j * (2 * k + 1)) % (4 * n)];
+        }
+        chebyshev->coefficients[j] = c * 2.0L / (long double)n;
+    }
+    chebyshev->coefficients[0] *= 0.5L;
+
+    free(samples);
+    return chebyshev;
+}
+
 struct interpolation const* piecewise_linear_interpolation(struct function const *const function, long double const x0, long double const x1, unsigned long const order) {
     if(x0 >= x1) {
         return NULL;
@@ -226,14 +844,17 @@ struct interpolation const* piecewise_linear_interpolation(struct function const
     }
 
     piecewise_linear->sampling_interval = sampled_function->sampling_interval;
-    long double * const coefficients = piecewise_linear->coefficients;
-
-    /* Initialise coefficients */
-    for(size_t i = 0; i < sampled_function->n_samples; i++) {
-        coefficients[i] = sampled_function->samples[i] / sampled_function->sampling_interval;
-    }
+    /* Evaluation only reads the grid, which keeps its own copy of the samples */
+    free(piecewise_linear->coefficients);
+    piecewise_linear->coefficients = NULL;
 
+    piecewise_linear->grid = create_grid_evaluator(GRID_KERNEL_LINEAR, x0, x1, sampled_function->sampling_interval, sampled_function->samples, sampled_function->n_samples);
     destroy_sample(sampled_function);
+    if(piecewise_linear->grid == NULL) {
+        fprintf(stderr, "piecewise_linear_interpolation(): Unable to allocate memory.\n");
+        destroy_interpolation(piecewise_linear);
+        return NULL;
+    }
 
     return piecewise_linear;
 }
@@ -266,16 +887,121 @@ struct interpolation const* raised_cosine_interpolation(struct function const *c
     }
 
     raised_cosine->sampling_interval = sampled_function->sampling_interval;
-    long double * const coefficients = raised_cosine->coefficients;
+    /* Evaluation only reads the grid, which keeps its own copy of the samples */
+    free(raised_cosine->coefficients);
+    raised_cosine->coefficients = NULL;
 
-    /* Initialise coefficients */
-    for(size_t i = 0; i < sampled_function->n_samples; i++) {
-        coefficients[i] = sampled_function->samples[i] / 2.0L;
+    raised_cosine->grid = create_grid_evaluator(GRID_KERNEL_RAISED_COSINE, x0, x1, sampled_function->sampling_interval, sampled_function->samples, sampled_function->n_samples);
+    destroy_sample(sampled_function);
+    if(raised_cosine->grid == NULL) {
+        fprintf(stderr, "raised_cosine_interpolation(): Unable to allocate memory.\n");
+        destroy_interpolation(raised_cosine);
+        return NULL;
+    }
+
+    return raised_cosine;
+}
+
+/* Thomas algorithm for the tridiagonal system with sub-diagonal sub[1..n-1],
+ * diagonal diagonal[0..n-1] and super-diagonal super[0..n-2]. rhs is
+ * overwritten with the solution and super with scratch values; the system
+ * must not need pivoting (diagonally dominant, as for splines). */
+static void solve_tridiagonal(size_t const n, long double const * const sub, long double const * const diagonal, long double * const super, long double * const rhs)
+{
+    long double pivot = diagonal[0];
+    rhs[0] /= pivot;
+    for(size_t i = 1; i < n; i++) {
+        super[i - 1] /= pivot;
+        pivot = diagonal[i] - sub[i] * super[i - 1];
+        rhs[i] = (rhs[i] - sub[i] * rhs[i - 1]) / pivot;
+    }
+    for(size_t i = n - 1; i != 0; i--) {
+        rhs[i - 1] -= super[i - 1] * rhs[i];
+    }
+}
+
+/* Natural spline if derivative is NULL, otherwise clamped to the derivative
+ * at both ends. In terms of m_i = M_i h**2 / 6 (M_i the second derivatives)
+ * the interior equations on the uniform grid are
+ * m_i-1 + 4 m_i + m_i+1 = y_i+1 - 2 y_i + y_i-1 */
+struct interpolation const* cubic_spline_interpolation(struct function const *const function, struct function const *const derivative, long double const x0, long double const x1, unsigned long const order) {
+    if(x0 >= x1 || order == 0) {
+        return NULL;
+    }
+    long double const sampling_interval = (x1 - x0) / ((long double)order);
+
+    struct sampled_function * const sampled_function = sample_values(function, x0, x1, sampling_interval);
+    if(sampled_function == NULL) {
+        fprintf(stderr, "cubic_spline_interpolation(): Unable to take samples.\n");
+        return NULL;
+    }
+    size_t const n = sampled_function->n_samples;
+
+    struct interpolation * const spline = allocate_interpolation(function, x0, x1, n - 1);
+    long double * const bands = malloc(sizeof(long double) * n * 3);
+    if(spline == NULL || bands == NULL || (spline->moments = malloc(sizeof(long double) * n)) == NULL) {
+        fprintf(stderr, "cubic_spline_interpolation(): Unable to allocate memory.\n");
+        if(spline != NULL) {
+            destroy_interpolation(spline);
+        }
+        free(bands);
+        destroy_sample(sampled_function);
+        return NULL;
+    }
+
+    if(sampled_function->name != NULL) {
+        size_t const len = strlen(sampled_function->name) + 60L;
+        spline->name = malloc(len * sizeof(char));
+        if(spline->name != NULL) {
+            snprintf(spline->name, len, "%s Cubic Spline of %s (order %ld)", derivative == NULL ? "Natural" : "Clamped", sampled_function->name, order);
+        }
+    }
+
+    spline->sampling_interval = sampled_function->sampling_interval;
+    long double const * const y = sampled_function->samples;
+    long double * const sub = bands, * const diagonal = bands + n, * const super = bands + 2 * n;
+    long double * const m = spline->moments;
+    for(size_t i = 0; i != n; i++) {
+        spline->coefficients[i] = y[i];
+        sub[i] = super[i] = 1.0L;
+        diagonal[i] = 4.0L;
+        m[i] = (i == 0 || i == n - 1) ? 0.0L : y[i + 1] - 2.0L * y[i] + y[i - 1];
     }
+    if(derivative == NULL) {
+        /* m_0 = m_n = 0 */
+        super[0] = sub[n - 1] = 0.0L;
+        diagonal[0] = diagonal[n - 1] = 1.0L;
+    } else {
+        /* 2 m_0 + m_1 = y_1 - y_0 - h f'(x_0), m_n-1 + 2 m_n = h f'(x_n) - (y_n - y_n-1) */
+        diagonal[0] = diagonal[n - 1] = 2.0L;
+        m[0] = y[1] - y[0] - spline->sampling_interval * derivative->f(x0, derivative->arg);
+        m[n - 1] = spline->sampling_interval * derivative->f(x0 + spline->sampling_interval * (long double)(n - 1), derivative->arg) - (y[n - 1] - y[n - 2]);
+    }
+    solve_tridiagonal(n, sub, diagonal, super, m);
 
+    free(bands);
     destroy_sample(sampled_function);
+    return spline;
+}
 
-    return raised_cosine;
+/* Solves the normal equations (V_T * V) c = V_T * f. The Gram matrix is SPD by
+ * construction, so Cholesky is tried first; LU is the fallback for when it is
+ * too ill-conditioned for that to hold numerically (high orders). */
+static struct matrix* solve_normal_equations(struct matrix const * const V_T_by_V_PR, struct matrix const * const V_T_by_f_T)
+{
+    struct matrix * coefficients = NULL;
+    struct cholesky_factorization * const cholesky = cholesky_factor(V_T_by_V_PR);
+    if(cholesky != NULL) {
+        coefficients = cholesky_solve(cholesky, V_T_by_f_T);
+        destroy_cholesky_factorization(cholesky);
+        return coefficients;
+    }
+    struct lu_factorization * const lu = lu_factor(V_T_by_V_PR);
+    if(lu != NULL) {
+        coefficients = lu_solve(lu, V_T_by_f_T);
+        destroy_lu_factorization(lu);
+    }
+    return coefficients;
 }
 
 struct interpolation const* least_squares_interpolation(struct function const *const function, long double const x0, long double const x1, unsigned long const order) {
@@ -286,11 +1012,7 @@ struct interpolation const* least_squares_interpolation(struct function const *c
         printf("error\n");
         goto error1;
     }
-    struct matrix const f_T = {
-        .elements = (long double*)sampled_function->samples,
-        .cols = 1L,
-        .rows = sampled_function->n_samples
-    };
+    struct matrix const f_T = matrix_view_array((long double*)sampled_function->samples, 1L, sampled_function->n_samples);
     struct matrix * const V_T = create_matrix(sampled_function->n_samples, order + 1L);
     if(V_T == NULL) {
         printf("error\n");
@@ -308,34 +1030,25 @@ struct interpolation const* least_squares_interpolation(struct function const *c
     for(size_t i = 2; i <= (order + 1); i++) {
         matrix_set_row_vector_power(V_T, i, xs, (long double)i - 1.0L);
     }
-    struct matrix * const V = transpose_matrix(V_T);
-    if(V == NULL) {
+    struct matrix const V = matrix_view_transpose(V_T);
+    struct matrix * const V_T_by_V_PR = matrix_multiply(V_T, &V);
+    if(V_T_by_V_PR == NULL) {
         printf("error\n");
         goto error4;
     }
-    struct matrix * const V_T_by_V_PR = matrix_multiply(V_T, V);
-    if(V_T_by_V_PR == NULL) {
+    struct matrix * const V_T_by_f_T = matrix_multiply(V_T, &f_T);
+    if(V_T_by_f_T == NULL) {
         printf("error\n");
         goto error5;
     }
-    struct matrix * const V_T_by_V_PR_INV = matrix_inverse(V_T_by_V_PR);
-    if(V_T_by_V_PR_INV == NULL) {
-        printf("error\n");
-        goto error6;
-    }
-    struct matrix * const V_T_by_V_PR_INV_by_V_T = matrix_multiply(V_T_by_V_PR_INV, V_T);
-    if(V_T_by_V_PR_INV_by_V_T == NULL) {
-        printf("error\n");
-        goto error7;
-    }
-    struct matrix *const V_T_by_V_PR_INV_by_V_T_by_f_T = matrix_multiply(V_T_by_V_PR_INV_by_V_T, &f_T);
+    struct matrix *const V_T_by_V_PR_INV_by_V_T_by_f_T = solve_normal_equations(V_T_by_V_PR, V_T_by_f_T);
     if(V_T_by_V_PR_INV_by_V_T_by_f_T == NULL || V_T_by_V_PR_INV_by_V_T_by_f_T->cols != 1L) {
         printf("error\n");
-        goto error8;
+        goto error6;
     }
     least_squares = allocate_interpolation(function, x0, x1, order);
     if(least_squares == NULL) {
-        goto error9;
+        goto error7;
     }
     if(sampled_function->name != NULL) {
         size_t const len = strlen(sampled_function->name) + 60L;
@@ -348,16 +1061,12 @@ struct interpolation const* least_squares_interpolation(struct function const *c
         least_squares->coefficients[i] = V_T_by_V_PR_INV_by_V_T_by_f_T->elements[i];
     }
 
-error9:
-    destroy_matrix(V_T_by_V_PR_INV_by_V_T_by_f_T);
-error8:
-    destroy_matrix(V_T_by_V_PR_INV_by_V_T);
 error7:
-    destroy_matrix(V_T_by_V_PR_INV);
+    destroy_matrix(V_T_by_V_PR_INV_by_V_T_by_f_T);
 error6:
-    destroy_matrix(V_T_by_V_PR);
+    destroy_matrix(V_T_by_f_T);
 error5:
-    destroy_matrix(V);
+    destroy_matrix(V_T_by_V_PR);
 error4:
     free(xs);
 error3:
@@ -368,6 +1077,86 @@ error1:
     return least_squares;
 }
 
+/* Same fit as least_squares_interpolation(), but the normal equations are
+ * accumulated in a single pass over the sampling grid. V_T * V only depends on
+ * the power sums of x (up to x**(2 * order)) and V_T * f on the moments of f,
+ * so memory is O(order) no matter how many points are used. */
+struct interpolation const* streaming_least_squares_interpolation(struct function const *const function, long double const x0, long double const x1, unsigned long const order, unsigned long const points) {
+    if(x0 >= x1 || points == 0L) {
+        return NULL;
+    }
+    long double const sampling_interval = (x1 - x0) / ((long double)points);
+    size_t const n_samples = (size_t)(floorl((x1 - x0) / sampling_interval) + 1.0L);
+    struct interpolation * least_squares = NULL;
+
+    long double * const power_sums = malloc(sizeof(long double) * (2L * order + 1L));
+    if(power_sums == NULL) {
+        fprintf(stderr, "streaming_least_squares_interpolation(): Unable to allocate memory.\n");
+        goto error1;
+    }
+    struct matrix * const V_T_by_f_T = create_matrix(1L, order + 1L);
+    if(V_T_by_f_T == NULL) {
+        fprintf(stderr, "streaming_least_squares_interpolation(): Unable to allocate memory.\n");
+        goto error2;
+    }
+    for(size_t i = 0; i <= 2L * order; i++) {
+        power_sums[i] = 0.0L;
+    }
+    for(size_t i = 0; i <= order; i++) {
+        V_T_by_f_T->elements[i] = 0.0L;
+    }
+
+    long double x[LEAST_SQUARES_CHUNK], values[LEAST_SQUARES_CHUNK];
+    for(size_t first = 0; first < n_samples; first += LEAST_SQUARES_CHUNK) {
+        size_t const n = (n_samples - first < LEAST_SQUARES_CHUNK) ? n_samples - first : LEAST_SQUARES_CHUNK;
+        for(size_t i = 0; i != n; i++) {
+            x[i] = x0 + sampling_interval * ((long double)(first + i));
+        }
+        function_values(function, x, values, n);
+        precision_accumulate_moments(x0, sampling_interval, first, n, values, order, power_sums, V_T_by_f_T->elements);
+    }
+
+    struct matrix * const V_T_by_V_PR = create_matrix(order + 1L, order + 1L);
+    if(V_T_by_V_PR == NULL) {
+        fprintf(stderr, "streaming_least_squares_interpolation(): Unable to allocate memory.\n");
+        goto error3;
+    }
+    for(size_t i = 0; i <= order; i++) {
+        matrix_set_row_vector(V_T_by_V_PR, i + 1L, power_sums + i);
+    }
+    struct matrix * const coefficients = solve_normal_equations(V_T_by_V_PR, V_T_by_f_T);
+    if(coefficients == NULL) {
+        fprintf(stderr, "streaming_least_squares_interpolation(): Unable to solve the normal equations.\n");
+        goto error4;
+    }
+    least_squares = allocate_interpolation(function, x0, x1, order);
+    if(least_squares == NULL) {
+        fprintf(stderr, "streaming_least_squares_interpolation(): Unable to allocate memory.\n");
+        goto error5;
+    }
+    if(function->name != NULL) {
+        size_t const len = strlen(function->name) + 60L;
+        least_squares->name = malloc(len * sizeof(char));
+        if(least_squares->name != NULL) {
+            snprintf(least_squares->name, len, "Least Squares Interpolation of %s (order %ld)", function->name, order);
+        }
+    }
+    for(size_t i = 0L; i != coefficients->rows; i++) {
+        least_squares->coefficients[i] = coefficients->elements[i];
+    }
+
+error5:
+    destroy_matrix(coefficients);
+error4:
+    destroy_matrix(V_T_by_V_PR);
+error3:
+    destroy_matrix(V_T_by_f_T);
+error2:
+    free(power_sums);
+error1:
+    return least_squares;
+}
+
 static long double square_root_helper(double long const x, double long *k)
 {
     return x * x - *k;
@@ -417,8 +1206,96 @@ struct result square_root_calculator(double long const k) {
     }
 }
 
+/* Square root of a k outside the normal double range: k = m * 4^q with m in
+ * [0.25, 1), so sqrt(k) = sqrt(m) * 2^q with sqrt(m) computed in double */
+static long double square_root_scaled(long double const k)
+{
+    int e;
+    long double const m = frexpl(k, &e);
+    int const q = (e >= 0) ? (e + 1) / 2 : -((-e) / 2);
+    long double const scaled = ldexpl(m, e - 2 * q);
+    long double x = (long double)sqrt((double)scaled);
+    x = (x + scaled / x) / 2.0L;
+    return ldexpl(x, q);
+}
+
+struct square_root_job {
+    long double const* k;
+    struct result* results;
+};
+
+static void square_root_task(size_t const begin, size_t const end, void* const arg)
+{
+    struct square_root_job const* const job = arg;
+    double kd[SQUARE_ROOT_CHUNK], seed[SQUARE_ROOT_CHUNK];
+
+    for(size_t i = begin; i < end; i += SQUARE_ROOT_CHUNK) {
+        size_t const chunk = (end - i < SQUARE_ROOT_CHUNK) ? end - i : SQUARE_ROOT_CHUNK;
+        long double const* const k = job->k + i;
+        struct result* const results = job->results + i;
+
+        /* Halving the exponent in the bit pattern gives sqrt(k) within 4%, four
+         * Newton steps in double take it to double precision */
+        for(size_t j = 0; j != chunk; j++) {
+            kd[j] = (double)k[j];
+        }
+        for(size_t j = 0; j != chunk; j++) {
+            uint64_t bits;
+            memcpy(&bits, &kd[j], sizeof(bits));
+            bits = (bits >> 1) + UINT64_C(0x1FF7A3BEA91D9B1B);
+            memcpy(&seed[j], &bits, sizeof(bits));
+        }
+        for(int step = 0; step != 4; step++) {
+            for(size_t j = 0; j != chunk; j++) {
+                seed[j] = 0.5 * (seed[j] + kd[j] / seed[j]);
+            }
+        }
+        /* And one more in long double to full precision */
+        for(size_t j = 0; j != chunk; j++) {
+            long double const x0 = (long double)seed[j];
+            long double const x1 = (x0 + k[j] / x0) / 2.0L;
+            results[j].value = x1;
+            results[j].error = 2.0L * LDBL_EPSILON * x1;
+            results[j].iterations = 5L;
+            results[j].convergence_rate = 2;
+            results[j].evaluations = 0L;
+            results[j].time = 0.0L;
+        }
+        /* Lanes the double steps could not handle */
+        for(size_t j = 0; j != chunk; j++) {
+            if(k[j] >= (long double)DBL_MIN && k[j] <= (long double)DBL_MAX) {
+                continue;
+            }
+            results[j].error = 0.0L;
+            results[j].iterations = 0L;
+            if(k[j] < 0.0L || isnan(k[j])) {
+                results[j].value = NAN;
+            } else if(k[j] == 0.0L || isinf(k[j])) {
+                results[j].value = k[j];
+            } else {
+                results[j].value = square_root_scaled(k[j]);
+                results[j].error = 2.0L * LDBL_EPSILON * results[j].value;
+                results[j].iterations = 2L;
+            }
+        }
+    }
+}
+
+/* square_root_calculator() for n values of k at once, in parallel. Instead of
+ * bisecting, every k starts from an estimate made from its exponent and takes
+ * a fixed number of Newton steps, so all the lanes run the same code. The
+ * last step starts within double precision, so the error is only that of
+ * rounding, reported as an absolute bound of two ulps. */
+void square_root_values(long double const* const k, struct result* const results, size_t const n) {
+    struct square_root_job job = {
+        k,
+        results
+    };
+    parallel_for(n, 16L * SQUARE_ROOT_CHUNK, square_root_task, &job);
+}
+
 struct result adjusting_newtons_method(struct function const* function, struct function const* derivative, long double x0, unsigned long max_iterations, long double tolerance) {
-    struct result result;
+    struct result result = {NAN, NAN, 0L, 0};
     char adjusting = 1;
     long double errors[] = {0.0L, 0.0L, 0.0L};
     long double m = 1.0L;
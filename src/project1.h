@@ -23,11 +23,21 @@
 
 struct result bisection_method(struct function const* function, long double x0, long double x1, long double tolerance);
 
+struct result* multi_bisection_method(struct function const* function, long double const* x0, long double const* x1, size_t n, long double tolerance);
+struct result brent_method(struct function const* function, long double x0, long double x1, long double tolerance);
+struct result illinois_method(struct function const* function, long double x0, long double x1, long double tolerance);
+struct result* find_roots(struct function const* function, struct function const* derivative, long double start, long double end, size_t steps, long double tolerance, size_t* count);
 struct result newtons_method(struct function const* function, struct function const* derivative, long double x0, unsigned long max_iterations, long double tolerance);
+struct result secant_method(struct function const* function, long double x0, long double x1, unsigned long max_iterations, long double tolerance);
 struct result altered_newtons_method(struct function const* function, struct function const* derivative, struct function const* secondderivative, long double x0, unsigned long max_iterations, long double tolerance);
 struct interpolation const* lagrange_interpolation(struct function const* function, long double x0, long double x1, unsigned long order);
+struct interpolation const* barycentric_lagrange_interpolation(struct function const* function, long double x0, long double x1, unsigned long order, enum interpolation_nodes nodes);
+struct interpolation const* chebyshev_interpolation(struct function const* function, long double x0, long double x1, unsigned long order);
 struct interpolation const* piecewise_linear_interpolation(struct function const* function, long double x0, long double x1, unsigned long order);
 struct interpolation const* raised_cosine_interpolation(struct function const* function, long double x0, long double x1, unsigned long order);
+struct interpolation const* cubic_spline_interpolation(struct function const* function, struct function const* derivative, long double x0, long double x1, unsigned long order);
 struct interpolation const* least_squares_interpolation(struct function const* function, long double x0, long double x1, unsigned long order);
+struct interpolation const* streaming_least_squares_interpolation(struct function const* function, long double x0, long double x1, unsigned long order, unsigned long points);
 struct result square_root_calculator(double long const k);
+void square_root_values(long double const* k, struct result* results, size_t n);
 struct result adjusting_newtons_method(struct function const* function, struct function const* derivative, long double x0, unsigned long max_iterations, long double tolerance);
@@ -0,0 +1,227 @@
+/*
+ Copyright (c) 2015 Ricardo Iván Vieitez Parra
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "thread_pool.h"
+#include "task_graph.h"
+
+enum task_state {
+    TASK_WAITING,
+    TASK_RUNNING,
+    TASK_SUCCEEDED,
+    TASK_FAILED
+};
+
+struct task {
+    int (*run)(void*);
+    void* arg;
+    enum task_state state;
+    /* Dependencies not finished yet */
+    size_t pending;
+    char dependency_failed;
+    size_t* dependents;
+    size_t n_dependents;
+};
+
+struct task_graph {
+    struct task* tasks;
+    size_t n_tasks;
+    size_t capacity;
+    pthread_mutex_t mutex;
+    size_t n_failed;
+};
+
+struct task_graph* create_task_graph(void)
+{
+    struct task_graph * const graph = malloc(sizeof(struct task_graph));
+    if(graph == NULL) {
+        fprintf(stderr, "create_task_graph(): Unable to allocate memory.\n");
+        return NULL;
+    }
+    graph->tasks = NULL;
+    graph->n_tasks = 0;
+    graph->capacity = 0;
+    graph->n_failed = 0;
+    pthread_mutex_init(&graph->mutex, NULL);
+    return graph;
+}
+
+void destroy_task_graph(struct task_graph * const graph)
+{
+    if(graph == NULL) {
+        return;
+    }
+    for(size_t i = 0; i != graph->n_tasks; i++) {
+        free(graph->tasks[i].dependents);
+    }
+    free(graph->tasks);
+    pthread_mutex_destroy(&graph->mutex);
+    free(graph);
+}
+
+size_t task_graph_add(struct task_graph * const graph, int (* const run)(void*), void * const arg)
+{
+    if(graph->n_tasks == graph->capacity) {
+        size_t const capacity = (graph->capacity == 0) ? 16 : 2 * graph->capacity;
+        struct task * const tasks = realloc(graph->tasks, sizeof(struct task) * capacity);
+        if(tasks == NULL) {
+            fprintf(stderr, "task_graph_add(): Unable to allocate memory.\n");
+            return (size_t)-1;
+        }
+        graph->tasks = tasks;
+        graph->capacity = capacity;
+    }
+    struct task * const task = &graph->tasks[graph->n_tasks];
+    task->run = run;
+    task->arg = arg;
+    task->state = TASK_WAITING;
+    task->pending = 0;
+    task->dependency_failed = 0;
+    task->dependents = NULL;
+    task->n_dependents = 0;
+    return graph->n_tasks++;
+}
+
+char task_graph_depend(struct task_graph * const graph, size_t const task, size_t const dependency)
+{
+    struct task * const before = &graph->tasks[dependency];
+    size_t * const dependents = realloc(before->dependents, sizeof(size_t) * (before->n_dependents + 1));
+    if(dependents == NULL) {
+        fprintf(stderr, "task_graph_depend(): Unable to allocate memory.\n");
+        return 1;
+    }
+    dependents[before->n_dependents++] = task;
+    before->dependents = dependents;
+    graph->tasks[task].pending++;
+    return 0;
+}
+
+/* First waiting task with no pending dependencies. Called with the mutex held */
+static struct task* ready_task(struct task_graph * const graph)
+{
+    for(size_t i = 0; i != graph->n_tasks; i++) {
+        if(graph->tasks[i].state == TASK_WAITING && graph->tasks[i].pending == 0) {
+            return &graph->tasks[i];
+        }
+    }
+    return NULL;
+}
+
+/* Every chunk runs ready tasks until none is left, then returns rather than
+ * waiting, so pool threads stay free to help the parallel_for() calls tasks
+ * make. A task only becomes ready when its last dependency finishes: the
+ * thread that finished it takes one of the tasks it released itself and
+ * hands the rest to a new parallel_for() over this function, so they start
+ * on idle workers at once. Without cycles every task thus runs before the
+ * last chunk returns. */
+static void task_graph_task(size_t const begin, size_t const end, void * const arg)
+{
+    struct task_graph * const graph = arg;
+    pthread_mutex_lock(&graph->mutex);
+    struct task* task;
+    while((task = ready_task(graph)) != NULL) {
+        task->state = TASK_RUNNING;
+        char const skip = task->dependency_failed;
+        pthread_mutex_unlock(&graph->mutex);
+
+        int const status = skip ? 1 : task->run(task->arg);
+
+        pthread_mutex_lock(&graph->mutex);
+        task->state = (status == 0) ? TASK_SUCCEEDED : TASK_FAILED;
+        if(status != 0) {
+            graph->n_failed++;
+        }
+        size_t released = 0;
+        for(size_t j = 0; j != task->n_dependents; j++) {
+            struct task * const dependent = &graph->tasks[task->dependents[j]];
+            if(--dependent->pending == 0) {
+                released++;
+            }
+            if(status != 0) {
+                dependent->dependency_failed = 1;
+            }
+        }
+        if(released > 1) {
+            pthread_mutex_unlock(&graph->mutex);
+            parallel_for(released, 1, task_graph_task, graph);
+            pthread_mutex_lock(&graph->mutex);
+        }
+    }
+    pthread_mutex_unlock(&graph->mutex);
+}
+
+/* Kahn's algorithm on a copy of the pending counts */
+static char has_cycle(struct task_graph const * const graph)
+{
+    size_t * const pending = malloc(sizeof(size_t) * graph->n_tasks);
+    size_t * const queue = malloc(sizeof(size_t) * graph->n_tasks);
+    size_t head = 0, tail = 0;
+    if(pending == NULL || queue == NULL) {
+        fprintf(stderr, "task_graph_run(): Unable to allocate memory.\n");
+        free(pending);
+        free(queue);
+        return 1;
+    }
+    for(size_t i = 0; i != graph->n_tasks; i++) {
+        pending[i] = graph->tasks[i].pending;
+        if(pending[i] == 0) {
+            queue[tail++] = i;
+        }
+    }
+    while(head != tail) {
+        struct task const * const task = &graph->tasks[queue[head++]];
+        for(size_t j = 0; j != task->n_dependents; j++) {
+            if(--pending[task->dependents[j]] == 0) {
+                queue[tail++] = task->dependents[j];
+            }
+        }
+    }
+    free(pending);
+    free(queue);
+    return tail != graph->n_tasks;
+}
+
+size_t task_graph_run(struct task_graph * const graph)
+{
+    if(has_cycle(graph)) {
+        fprintf(stderr, "task_graph_run(): The tasks depend on each other in a cycle.\n");
+        for(size_t i = 0; i != graph->n_tasks; i++) {
+            graph->tasks[i].state = TASK_FAILED;
+        }
+        return graph->n_tasks;
+    }
+    graph->n_failed = 0;
+    parallel_for(graph->n_tasks, 1, task_graph_task, graph);
+    return graph->n_failed;
+}
+
+char task_graph_failed(struct task_graph const * const graph, size_t const task)
+{
+    return graph->tasks[task].state != TASK_SUCCEEDED;
+}
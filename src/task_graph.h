@@ -0,0 +1,44 @@
+/*
+ Copyright (c) 2015 Ricardo Iván Vieitez Parra
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+
+
+/* Runs tasks with dependencies between them concurrently on the thread pool.
+ *
+ * A task starts once every task it depends on has finished successfully;
+ * tasks depending on one that failed (returned non-zero) are skipped and
+ * count as failed too. Tasks may call parallel_for() themselves. Ready tasks
+ * are started in the order they were added. Dependencies must not form a
+ * cycle: task_graph_run() then fails every task without running any. */
+
+struct task_graph;
+
+struct task_graph* create_task_graph(void);
+void destroy_task_graph(struct task_graph*);
+/* Returns the id of the new task, or (size_t)-1 if out of memory */
+size_t task_graph_add(struct task_graph*, int (*run)(void*), void* arg);
+/* task will not start before dependency has finished. Returns non-zero if out of memory */
+char task_graph_depend(struct task_graph*, size_t task, size_t dependency);
+/* Runs every task and waits for them. Returns the number of tasks that failed or were skipped */
+size_t task_graph_run(struct task_graph*);
+/* After task_graph_run(): 0 if the task ran and succeeded */
+char task_graph_failed(struct task_graph const*, size_t task);
@@ -0,0 +1,99 @@
+/*
+ Copyright (c) 2015 Ricardo Iván Vieitez Parra
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+
+
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include "thread_pool.h"
+#include "task_graph.h"
+
+/* project1_test_task_graph
+ *
+ * Two tasks that only depend on one producer must run at the same time once
+ * it finishes, even after the chunks that started the independent tasks have
+ * returned. Each dependent waits for the other to start, up to
+ * OVERLAP_TIMEOUT_MS, and fails if it never does. */
+
+#define OVERLAP_TIMEOUT_MS 2000
+#define TEST_THREADS 4
+
+static int running;
+
+static void sleep_ms(long const ms)
+{
+    struct timespec const ts = {ms / 1000, (ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+static int quick_task(void * const arg)
+{
+    return 0;
+}
+
+static int producer_task(void * const arg)
+{
+    sleep_ms(50);
+    return 0;
+}
+
+static int dependent_task(void * const arg)
+{
+    __atomic_add_fetch(&running, 1, __ATOMIC_SEQ_CST);
+    for(int i = 0; i != OVERLAP_TIMEOUT_MS; i++) {
+        if(__atomic_load_n(&running, __ATOMIC_SEQ_CST) == 2) {
+            return 0;
+        }
+        sleep_ms(1);
+    }
+    fprintf(stderr, "%s did not overlap with the other dependent.\n", (char const*)arg);
+    return 1;
+}
+
+int main(void)
+{
+    thread_pool_set_threads(TEST_THREADS);
+    struct task_graph * const graph = create_task_graph();
+    if(graph == NULL) {
+        return EXIT_FAILURE;
+    }
+    task_graph_add(graph, quick_task, NULL);
+    size_t const producer = task_graph_add(graph, producer_task, NULL);
+    size_t const first = task_graph_add(graph, dependent_task, "first dependent");
+    size_t const second = task_graph_add(graph, dependent_task, "second dependent");
+    if(producer == (size_t)-1 || first == (size_t)-1 || second == (size_t)-1 || task_graph_depend(graph, first, producer) || task_graph_depend(graph, second, producer)) {
+        destroy_task_graph(graph);
+        return EXIT_FAILURE;
+    }
+    size_t const failed = task_graph_run(graph);
+    destroy_task_graph(graph);
+    if(failed != 0) {
+        fprintf(stderr, "%lu tasks failed.\n", failed);
+        return EXIT_FAILURE;
+    }
+    printf("The dependents of one producer overlapped.\n");
+    return EXIT_SUCCESS;
+}
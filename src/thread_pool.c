@@ -0,0 +1,251 @@
+/*
+ Copyright (c) 2015 Ricardo Iván Vieitez Parra
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "thread_pool.h"
+
+struct parallel_job {
+    void (*body)(size_t, size_t, void*);
+    void* arg;
+    size_t n;
+    size_t grain;
+    size_t n_chunks;
+    size_t next_chunk;
+    size_t done_chunks;
+    struct parallel_job* next;
+};
+
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    /* Jobs that still have unclaimed chunks, oldest first */
+    struct parallel_job* jobs;
+    pthread_t* workers;
+    size_t n_workers;
+    size_t threads;
+    char shutdown;
+} pool = {
+    PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_COND_INITIALIZER,
+    PTHREAD_COND_INITIALIZER,
+    NULL,
+    NULL,
+    0,
+    0,
+    0
+};
+
+/* Holds index + 1 for the workers, unset for any other thread */
+static pthread_key_t thread_index_key;
+static pthread_once_t thread_index_once = PTHREAD_ONCE_INIT;
+
+static void create_thread_index_key(void)
+{
+    pthread_key_create(&thread_index_key, NULL);
+}
+
+static size_t default_threads(void)
+{
+    char const * const env = getenv("PROJECT1_THREADS");
+    if(env != NULL) {
+        char* end;
+        unsigned long const threads = strtoul(env, &end, 10);
+        if(end != env && *end == '\0' && threads != 0) {
+            return threads;
+        }
+        fprintf(stderr, "Ignoring invalid PROJECT1_THREADS=%s\n", env);
+    }
+    long const cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cpus > 0) ? (size_t)cpus : 1;
+}
+
+/* Claim the next chunk of the given job (or of the oldest queued job if job
+ * is NULL). Called with the mutex held. Returns NULL if there is no work. */
+static struct parallel_job* claim_chunk(struct parallel_job* job, size_t* const chunk)
+{
+    if(job == NULL) {
+        job = pool.jobs;
+    }
+    if(job == NULL || job->next_chunk == job->n_chunks) {
+        return NULL;
+    }
+    *chunk = job->next_chunk++;
+    if(job->next_chunk == job->n_chunks) {
+        /* Fully claimed, unlink it from the queue */
+        struct parallel_job** p = &pool.jobs;
+        while(*p != job) {
+            p = &(*p)->next;
+        }
+        *p = job->next;
+    }
+    return job;
+}
+
+/* Runs a claimed chunk. Called with the mutex held, returns with it held. */
+static void run_chunk(struct parallel_job* const job, size_t const chunk)
+{
+    size_t const begin = chunk * job->grain;
+    size_t const end = (job->n - begin < job->grain) ? job->n : begin + job->grain;
+    pthread_mutex_unlock(&pool.mutex);
+    job->body(begin, end, job->arg);
+    pthread_mutex_lock(&pool.mutex);
+    if(++job->done_chunks == job->n_chunks) {
+        pthread_cond_broadcast(&pool.done);
+    }
+}
+
+static void* worker(void* const index)
+{
+    struct parallel_job* job;
+    size_t chunk;
+    pthread_setspecific(thread_index_key, index);
+    pthread_mutex_lock(&pool.mutex);
+    for(;;) {
+        while(!pool.shutdown && (job = claim_chunk(NULL, &chunk)) == NULL) {
+            pthread_cond_wait(&pool.work, &pool.mutex);
+        }
+        if(pool.shutdown) {
+            break;
+        }
+        run_chunk(job, chunk);
+    }
+    pthread_mutex_unlock(&pool.mutex);
+    return NULL;
+}
+
+/* Called with the mutex held */
+static void start_workers(void)
+{
+    if(pool.threads == 0) {
+        pool.threads = default_threads();
+    }
+    if(pool.workers != NULL || pool.threads < 2) {
+        return;
+    }
+    pool.workers = malloc(sizeof(pthread_t) * (pool.threads - 1));
+    if(pool.workers == NULL) {
+        fprintf(stderr, "thread_pool: Unable to allocate memory, running single-threaded.\n");
+        pool.threads = 1;
+        return;
+    }
+    pool.shutdown = 0;
+    pthread_once(&thread_index_once, create_thread_index_key);
+    for(pool.n_workers = 0; pool.n_workers != pool.threads - 1; pool.n_workers++) {
+        if(pthread_create(&pool.workers[pool.n_workers], NULL, worker, (void*)(uintptr_t)(pool.n_workers + 1)) != 0) {
+            fprintf(stderr, "thread_pool: Unable to start worker %lu.\n", pool.n_workers + 1);
+            break;
+        }
+    }
+}
+
+size_t thread_pool_threads(void)
+{
+    pthread_mutex_lock(&pool.mutex);
+    if(pool.threads == 0) {
+        pool.threads = default_threads();
+    }
+    size_t const threads = pool.threads;
+    pthread_mutex_unlock(&pool.mutex);
+    return threads;
+}
+
+size_t thread_pool_thread_index(void)
+{
+    pthread_once(&thread_index_once, create_thread_index_key);
+    return (size_t)(uintptr_t)pthread_getspecific(thread_index_key);
+}
+
+void thread_pool_set_threads(size_t const threads)
+{
+    pthread_mutex_lock(&pool.mutex);
+    if(pool.workers != NULL) {
+        pool.shutdown = 1;
+        pthread_cond_broadcast(&pool.work);
+        pthread_mutex_unlock(&pool.mutex);
+        for(size_t i = 0; i != pool.n_workers; i++) {
+            pthread_join(pool.workers[i], NULL);
+        }
+        pthread_mutex_lock(&pool.mutex);
+        free(pool.workers);
+        pool.workers = NULL;
+        pool.n_workers = 0;
+        pool.shutdown = 0;
+    }
+    pool.threads = (threads == 0) ? default_threads() : threads;
+    pthread_mutex_unlock(&pool.mutex);
+}
+
+void parallel_for(size_t const n, size_t grain, void (* const body)(size_t, size_t, void*), void* const arg)
+{
+    if(n == 0) {
+        return;
+    }
+    if(grain == 0) {
+        grain = 1;
+    }
+    struct parallel_job job = {
+        body,
+        arg,
+        n,
+        grain,
+        (n + grain - 1) / grain,
+        0,
+        0,
+        NULL
+    };
+    if(job.n_chunks == 1) {
+        body(0, n, arg);
+        return;
+    }
+    pthread_mutex_lock(&pool.mutex);
+    start_workers();
+    if(pool.n_workers == 0) {
+        pthread_mutex_unlock(&pool.mutex);
+        for(size_t begin = 0; begin < n; begin += grain) {
+            body(begin, (n - begin < grain) ? n : begin + grain, arg);
+        }
+        return;
+    }
+    struct parallel_job** tail = &pool.jobs;
+    while(*tail != NULL) {
+        tail = &(*tail)->next;
+    }
+    *tail = &job;
+    pthread_cond_broadcast(&pool.work);
+    size_t chunk;
+    while(claim_chunk(&job, &chunk) != NULL) {
+        run_chunk(&job, chunk);
+    }
+    while(job.done_chunks != job.n_chunks) {
+        pthread_cond_wait(&pool.done, &pool.mutex);
+    }
+    pthread_mutex_unlock(&pool.mutex);
+}
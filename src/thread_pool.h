@@ -0,0 +1,40 @@
+/*
+ Copyright (c) 2015 Ricardo Iván Vieitez Parra
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+
+/* Shared worker pool.
+ *
+ * The pool is created lazily on first use with thread_pool_threads() - 1
+ * workers; the thread calling parallel_for() always takes part in the work,
+ * so nested parallel_for() calls (from inside a body) cannot deadlock.
+ *
+ * The number of threads is taken, in order, from thread_pool_set_threads(),
+ * the PROJECT1_THREADS environment variable, or the number of online CPUs. */
+
+size_t thread_pool_threads(void);
+/* 1 to thread_pool_threads() - 1 in the workers, 0 in any other thread */
+size_t thread_pool_thread_index(void);
+/* Must not be called while a parallel_for() is running. 0 restores the default */
+void thread_pool_set_threads(size_t threads);
+/* Calls body(begin, end, arg) over [0, n) in chunks of grain elements.
+ * Chunk boundaries only depend on n and grain, never on the number of threads. */
+void parallel_for(size_t n, size_t grain, void (*body)(size_t begin, size_t end, void* arg), void* arg);
@@ -20,20 +20,44 @@
  THE SOFTWARE.
 */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdarg.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <math.h>
+#include <float.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
 #include "utilities.h"
+#include "precision.h"
+#include "thread_pool.h"
+#include "float_format.h"
 
 #define POLYNOMIAL_ERROR_POINT_MULTIPLIER 524288.0L
-
-#ifndef M_PI
-#define M_PI 3.1415926535897932384626433832795028841971L
-#endif
+#define SAMPLE_CHUNK 1024L
+#define FUNCTION_ERROR_PARTS 64L
+#define QUADRATURE_MAX_INTERVALS 4096L
+#define CSV_CHUNK 4096L
+#define CSV_WINDOW 16L
+#define CSV_ROW_MAX (2L * FORMAT_DOUBLE_MAX + 2L)
 
 /* Utility functions */
+void function_values(struct function const * const function, long double const * const x, long double * const y, size_t const n)
+{
+    if(function->f_batch != NULL) {
+        function->f_batch(x, y, n, function->arg);
+        return;
+    }
+    for(size_t i = 0; i != n; i++) {
+        y[i] = function->f(x[i], function->arg);
+    }
+}
+
 struct sampled_function* sample_values(struct function const * const function, long double const start, long double const end, long double const sampling_interval) {
     if(start >= end) {
         return NULL;
@@ -63,8 +87,13 @@ struct sampled_function* sample_values(struct function const * const function, l
     sampled_function->sampling_interval = sampling_interval;
     sampled_function->n_samples = n_samples;
     sampled_function->samples = samples;
-    for(size_t i = 0; i != n_samples; i++) {
-        samples[i] = function->f(start + (sampling_interval * ((long double)i)), function->arg);
+    long double x[SAMPLE_CHUNK];
+    for(size_t i = 0; i < n_samples; i += SAMPLE_CHUNK) {
+        size_t const chunk = (n_samples - i < SAMPLE_CHUNK) ? n_samples - i : SAMPLE_CHUNK;
+        for(size_t j = 0; j != chunk; j++) {
+            x[j] = start + (sampling_interval * ((long double)(i + j)));
+        }
+        function_values(function, x, samples + i, chunk);
     }
     return sampled_function;
 }
@@ -115,80 +144,782 @@ struct sampled_function* sample_derivative(struct sampled_function const * const
 
 // TODO: report rate of convergence
 void report_result(struct result const * const result)
+{
+    fprint_result(stdout, result);
+}
+
+void fprint_result(FILE * const file, struct result const * const result)
 {
     size_t precision = 8;
     if(result->error != 0.0L && isfinite(result->error)) {
         precision = 1L + -1L * (size_t)(ceill(log10l(fabsl(result->error))));
     }
-    printf("result: %.*Lf ± %.1LE, iterations: %ld, convergence rate: %u\n", (int)precision, result->value, result->error, result->iterations, result->convergence_rate);
+    fprintf(file, "result: %.*Lf ± %.1LE, iterations: %ld, convergence rate: %u", (int)precision, result->value, result->error, result->iterations, result->convergence_rate);
+    if(result->evaluations != 0) {
+        fprintf(file, ", evaluations: %lu, time: %.2Lf us", result->evaluations, result->time * 1E6L);
+    }
+    fprintf(file, "\n");
 }
 
-void gnuplot(char const * const base, size_t const n_functions, long double const start, long double const end, unsigned long points, ...)
+/* Number of points gnuplot() exports: x = start, start + interval, ... while x < end */
+static size_t gnuplot_points(long double const start, long double const end, long double const sampling_interval)
+{
+    size_t n = 0;
+    for(long double x = start; x < end; x += sampling_interval) {
+        n++;
+    }
+    return n;
+}
+
+/* CSV export runs as a two stage pipeline: the thread pool evaluates and
+ * formats a window of CSV_WINDOW tasks of CSV_CHUNK points (tasks of all the
+ * files interleaved, so they all progress together) while a writer thread
+ * writes out the previous window, in order. */
+struct csv_buffer {
+    char* text;
+    size_t length;
+};
+
+struct csv_export {
+    struct function const * const* functions;
+    FILE** files;
+    size_t n_functions;
+    long double start;
+    long double sampling_interval;
+    size_t n_points;
+    size_t first_task;
+    struct csv_buffer* window;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    struct csv_buffer* pending;
+    size_t pending_first_task;
+    size_t pending_count;
+    char finished;
+    char write_failed;
+};
+
+static void csv_format_task(size_t const begin, size_t const end, void * const arg)
+{
+    struct csv_export const * const export = arg;
+    long double x[SAMPLE_CHUNK], y[SAMPLE_CHUNK];
+    for(size_t t = begin; t != end; t++) {
+        size_t const task = export->first_task + t;
+        struct function const * const function = export->functions[task % export->n_functions];
+        size_t const first = (task / export->n_functions) * CSV_CHUNK;
+        size_t const last = (export->n_points - first < CSV_CHUNK) ? export->n_points : first + CSV_CHUNK;
+        char* text = export->window[t].text;
+        for(size_t i = first; i < last; i += SAMPLE_CHUNK) {
+            size_t const chunk = (last - i < SAMPLE_CHUNK) ? last - i : SAMPLE_CHUNK;
+            for(size_t j = 0; j != chunk; j++) {
+                x[j] = export->start + export->sampling_interval * ((long double)(i + j));
+            }
+            function_values(function, x, y, chunk);
+            for(size_t j = 0; j != chunk; j++) {
+                text += format_double((double)x[j], text);
+                *text++ = ',';
+                text += format_double((double)y[j], text);
+                *text++ = '\n';
+            }
+        }
+        export->window[t].length = (size_t)(text - export->window[t].text);
+    }
+}
+
+/* Returns non-zero if any write fell short */
+static char csv_write_window(struct csv_export const * const export, struct csv_buffer const * const window, size_t const first_task, size_t const count)
 {
-    char const **function_names = malloc(sizeof(char*)*n_functions);
-    struct function const *t_f;
+    char failed = 0;
+    for(size_t t = 0; t != count; t++) {
+        if(fwrite(window[t].text, 1, window[t].length, export->files[(first_task + t) % export->n_functions]) != window[t].length) {
+            failed = 1;
+        }
+    }
+    return failed;
+}
+
+static void* csv_writer(void * const arg)
+{
+    struct csv_export * const export = arg;
+    pthread_mutex_lock(&export->mutex);
+    for(;;) {
+        while(export->pending == NULL && !export->finished) {
+            pthread_cond_wait(&export->cond, &export->mutex);
+        }
+        if(export->pending == NULL) {
+            break;
+        }
+        struct csv_buffer const * const window = export->pending;
+        size_t const first_task = export->pending_first_task, count = export->pending_count;
+        pthread_mutex_unlock(&export->mutex);
+        char const failed = csv_write_window(export, window, first_task, count);
+        pthread_mutex_lock(&export->mutex);
+        export->write_failed |= failed;
+        export->pending = NULL;
+        pthread_cond_broadcast(&export->cond);
+    }
+    pthread_mutex_unlock(&export->mutex);
+    return NULL;
+}
+
+static char gnuplot_write_csv(FILE ** const files, struct function const * const * const functions, size_t const n_functions, long double const start, long double const end, long double const sampling_interval)
+{
+    size_t const n_points = gnuplot_points(start, end, sampling_interval);
+    size_t const n_tasks = n_functions * ((n_points + CSV_CHUNK - 1) / CSV_CHUNK);
+    struct csv_buffer windows[2][CSV_WINDOW];
+    char failed = 0, threaded = 1;
+    pthread_t writer;
+    struct csv_export export = {
+        functions,
+        files,
+        n_functions,
+        start,
+        sampling_interval,
+        n_points,
+        0,
+        NULL,
+        PTHREAD_MUTEX_INITIALIZER,
+        PTHREAD_COND_INITIALIZER,
+        NULL,
+        0,
+        0,
+        0,
+        0
+    };
+    size_t allocated = 0;
+    for(; allocated != 2 * CSV_WINDOW; allocated++) {
+        if((windows[allocated / CSV_WINDOW][allocated % CSV_WINDOW].text = malloc(CSV_CHUNK * CSV_ROW_MAX)) == NULL) {
+            fprintf(stderr, "gnuplot(): Unable to allocate memory.\n");
+            failed = 1;
+            goto cleanup;
+        }
+    }
+    if(pthread_create(&writer, NULL, csv_writer, &export) != 0) {
+        threaded = 0;
+    }
+    for(size_t w = 0; export.first_task < n_tasks; w ^= 1) {
+        size_t const count = (n_tasks - export.first_task < CSV_WINDOW) ? n_tasks - export.first_task : CSV_WINDOW;
+        export.window = windows[w];
+        parallel_for(count, 1, csv_format_task, &export);
+        if(!threaded) {
+            export.write_failed |= csv_write_window(&export, windows[w], export.first_task, count);
+        } else {
+            pthread_mutex_lock(&export.mutex);
+            while(export.pending != NULL) {
+                pthread_cond_wait(&export.cond, &export.mutex);
+            }
+            export.pending = windows[w];
+            export.pending_first_task = export.first_task;
+            export.pending_count = count;
+            pthread_cond_broadcast(&export.cond);
+            pthread_mutex_unlock(&export.mutex);
+        }
+        export.first_task += count;
+    }
+    if(threaded) {
+        pthread_mutex_lock(&export.mutex);
+        export.finished = 1;
+        pthread_cond_broadcast(&export.cond);
+        pthread_mutex_unlock(&export.mutex);
+        pthread_join(writer, NULL);
+    }
+    if(export.write_failed) {
+        fprintf(stderr, "gnuplot(): Unable to write the exported data.\n");
+        failed = 1;
+    }
+cleanup:
+    while(allocated != 0) {
+        allocated--;
+        free(windows[allocated / CSV_WINDOW][allocated % CSV_WINDOW].text);
+    }
+    return failed;
+}
+
+/* Pairs of native float64 (x, y), written straight into a mapping of the file */
+static char gnuplot_write_binary(char const * const filename, struct function const * const function, long double const start, long double const end, long double const sampling_interval)
+{
+    long double x[SAMPLE_CHUNK], y[SAMPLE_CHUNK];
+    size_t const n = gnuplot_points(start, end, sampling_interval);
+    size_t const size = sizeof(double) * 2 * n;
+    char failed = 0;
+    int const fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if(fd < 0) {
+        fprintf(stderr, "gnuplot(): Unable to open %s.\n", filename);
+        return 1;
+    }
+    if(n == 0) {
+        goto cleanup;
+    }
+    if(ftruncate(fd, (off_t)size) != 0) {
+        fprintf(stderr, "gnuplot(): Unable to resize %s.\n", filename);
+        failed = 1;
+        goto cleanup;
+    }
+    double * const data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(data == MAP_FAILED) {
+        fprintf(stderr, "gnuplot(): Unable to map %s.\n", filename);
+        failed = 1;
+        goto cleanup;
+    }
+    for(size_t i = 0; i < n; i += SAMPLE_CHUNK) {
+        size_t const chunk = (n - i < SAMPLE_CHUNK) ? n - i : SAMPLE_CHUNK;
+        for(size_t j = 0; j != chunk; j++) {
+            x[j] = start + sampling_interval * ((long double)(i + j));
+        }
+        function_values(function, x, y, chunk);
+        for(size_t j = 0; j != chunk; j++) {
+            data[2 * (i + j)] = (double)x[j];
+            data[2 * (i + j) + 1] = (double)y[j];
+        }
+    }
+    munmap(data, size);
+cleanup:
+    close(fd);
+    return failed;
+}
+
+/* Decimated export: the curve is still evaluated at every point, streamed
+ * chunk by chunk through a visitor, but only the selected points are kept. */
+struct decimation {
+    size_t n_points;
+    size_t buckets;
+    size_t n;
+    long double* x;
+    long double* y;
+    size_t bucket;
+    /* min/max: extremes of the current bucket */
+    size_t min_index, max_index;
+    long double min_x, min_y, max_x, max_y;
+    /* LTTB: per bucket averages, the last point and the best candidate */
+    long double* average_x;
+    long double* average_y;
+    size_t* counts;
+    long double last_x, last_y;
+    long double best_x, best_y, best_area;
+};
+
+static void gnuplot_stream(struct function const * const function, long double const start, long double const sampling_interval, size_t const n_points, void (* const visit)(size_t, long double, long double, struct decimation*), struct decimation * const decimation)
+{
+    long double x[SAMPLE_CHUNK], y[SAMPLE_CHUNK];
+    for(size_t i = 0; i < n_points; i += SAMPLE_CHUNK) {
+        size_t const chunk = (n_points - i < SAMPLE_CHUNK) ? n_points - i : SAMPLE_CHUNK;
+        for(size_t j = 0; j != chunk; j++) {
+            x[j] = start + sampling_interval * ((long double)(i + j));
+        }
+        function_values(function, x, y, chunk);
+        for(size_t j = 0; j != chunk; j++) {
+            visit(i + j, x[j], y[j], decimation);
+        }
+    }
+}
+
+static void decimation_emit(struct decimation * const decimation, long double const x, long double const y)
+{
+    decimation->x[decimation->n] = x;
+    decimation->y[decimation->n] = y;
+    decimation->n++;
+}
+
+static void minmax_flush(struct decimation * const decimation)
+{
+    if(decimation->min_index == SIZE_MAX) {
+        return;
+    }
+    if(decimation->min_index < decimation->max_index) {
+        decimation_emit(decimation, decimation->min_x, decimation->min_y);
+        decimation_emit(decimation, decimation->max_x, decimation->max_y);
+    } else if(decimation->min_index > decimation->max_index) {
+        decimation_emit(decimation, decimation->max_x, decimation->max_y);
+        decimation_emit(decimation, decimation->min_x, decimation->min_y);
+    } else {
+        decimation_emit(decimation, decimation->min_x, decimation->min_y);
+    }
+    decimation->min_index = decimation->max_index = SIZE_MAX;
+}
+
+static void minmax_visit(size_t const i, long double const x, long double const y, struct decimation * const decimation)
+{
+    size_t const bucket = i * decimation->buckets / decimation->n_points;
+    if(bucket != decimation->bucket) {
+        minmax_flush(decimation);
+        decimation->bucket = bucket;
+    }
+    if(isnan(y)) {
+        return;
+    }
+    if(decimation->min_index == SIZE_MAX || y < decimation->min_y) {
+        decimation->min_index = i;
+        decimation->min_x = x;
+        decimation->min_y = y;
+    }
+    if(decimation->max_index == SIZE_MAX || y > decimation->max_y) {
+        decimation->max_index = i;
+        decimation->max_x = x;
+        decimation->max_y = y;
+    }
+}
+
+/* LTTB buckets split the interior points 1 .. n_points - 2 */
+static size_t lttb_bucket(size_t const i, struct decimation const * const decimation)
+{
+    return (i - 1) * decimation->buckets / (decimation->n_points - 2);
+}
+
+static void lttb_average_visit(size_t const i, long double const x, long double const y, struct decimation * const decimation)
+{
+    if(i == decimation->n_points - 1) {
+        decimation->last_x = x;
+        decimation->last_y = y;
+    }
+    if(i == 0 || i == decimation->n_points - 1 || isnan(y)) {
+        return;
+    }
+    size_t const bucket = lttb_bucket(i, decimation);
+    decimation->average_x[bucket] += x;
+    decimation->average_y[bucket] += y;
+    decimation->counts[bucket]++;
+}
+
+static void lttb_select_visit(size_t const i, long double const x, long double const y, struct decimation * const decimation)
+{
+    if(i == 0) {
+        decimation_emit(decimation, x, y);
+        return;
+    }
+    if(i == decimation->n_points - 1) {
+        if(decimation->best_area >= 0.0L) {
+            decimation_emit(decimation, decimation->best_x, decimation->best_y);
+        }
+        decimation_emit(decimation, x, y);
+        return;
+    }
+    size_t const bucket = lttb_bucket(i, decimation);
+    if(bucket != decimation->bucket) {
+        if(decimation->best_area >= 0.0L) {
+            decimation_emit(decimation, decimation->best_x, decimation->best_y);
+        }
+        decimation->bucket = bucket;
+        decimation->best_area = -1.0L;
+    }
+    if(isnan(y)) {
+        return;
+    }
+    /* Area of the triangle between the last selected point, this point and the next bucket's centroid */
+    long double const ax = decimation->x[decimation->n - 1], ay = decimation->y[decimation->n - 1];
+    long double cx = decimation->last_x, cy = decimation->last_y;
+    if(bucket + 1 < decimation->buckets && decimation->counts[bucket + 1] != 0) {
+        cx = decimation->average_x[bucket + 1] / (long double)decimation->counts[bucket + 1];
+        cy = decimation->average_y[bucket + 1] / (long double)decimation->counts[bucket + 1];
+    }
+    long double const area = fabsl((ax - cx) * (y - ay) - (ax - x) * (cy - ay));
+    if(area > decimation->best_area) {
+        decimation->best_area = area;
+        decimation->best_x = x;
+        decimation->best_y = y;
+    }
+}
+
+/* Fills decimation->x/y with at most target points of the curve; returns 1 on failure */
+static char gnuplot_decimate(struct gnuplot_options const * const options, struct function const * const function, long double const start, long double const sampling_interval, size_t const n_points, struct decimation * const decimation)
+{
+    size_t const target = options->target_points;
+    decimation->n_points = n_points;
+    decimation->n = 0;
+    decimation->bucket = 0;
+    decimation->min_index = decimation->max_index = SIZE_MAX;
+    decimation->average_x = decimation->average_y = NULL;
+    decimation->counts = NULL;
+    decimation->x = malloc(sizeof(long double) * target);
+    decimation->y = malloc(sizeof(long double) * target);
+    if(decimation->x == NULL || decimation->y == NULL) {
+        goto error;
+    }
+    if(options->decimation == GNUPLOT_DECIMATE_MINMAX) {
+        decimation->buckets = target / 2;
+        gnuplot_stream(function, start, sampling_interval, n_points, minmax_visit, decimation);
+        minmax_flush(decimation);
+        return 0;
+    }
+    decimation->buckets = target - 2;
+    decimation->average_x = calloc(decimation->buckets, sizeof(long double));
+    decimation->average_y = calloc(decimation->buckets, sizeof(long double));
+    decimation->counts = calloc(decimation->buckets, sizeof(size_t));
+    if(decimation->average_x == NULL || decimation->average_y == NULL || decimation->counts == NULL) {
+        goto error;
+    }
+    gnuplot_stream(function, start, sampling_interval, n_points, lttb_average_visit, decimation);
+    decimation->best_area = -1.0L;
+    gnuplot_stream(function, start, sampling_interval, n_points, lttb_select_visit, decimation);
+    free(decimation->average_x);
+    free(decimation->average_y);
+    free(decimation->counts);
+    return 0;
+error:
+    fprintf(stderr, "gnuplot(): Unable to allocate memory.\n");
+    free(decimation->x);
+    free(decimation->y);
+    free(decimation->average_x);
+    free(decimation->average_y);
+    free(decimation->counts);
+    return 1;
+}
+
+static char gnuplot_write_series(char const * const filename, enum gnuplot_format const format, long double const * const x, long double const * const y, size_t const n)
+{
+    char row[CSV_ROW_MAX];
+    FILE * const fp = fopen(filename, "wb");
+    if(fp == NULL) {
+        fprintf(stderr, "gnuplot(): Unable to open %s.\n", filename);
+        return 1;
+    }
+    char failed = 0;
+    for(size_t i = 0; i != n && !failed; i++) {
+        if(format == GNUPLOT_BINARY) {
+            double const pair[2] = {(double)x[i], (double)y[i]};
+            failed = fwrite(pair, sizeof(pair), 1, fp) != 1;
+        } else {
+            size_t length = format_double((double)x[i], row);
+            row[length++] = ',';
+            length += format_double((double)y[i], row + length);
+            row[length++] = '\n';
+            failed = fwrite(row, 1, length, fp) != length;
+        }
+    }
+    if(fclose(fp) != 0 || failed) {
+        fprintf(stderr, "gnuplot(): Unable to write %s.\n", filename);
+        return 1;
+    }
+    return 0;
+}
+
+void gnuplot_functions(struct gnuplot_options const * const options, char const * const base, size_t const n_functions, long double const start, long double const end, unsigned long const points, struct function const * const * const functions)
+{
+    static char const * const extensions[] = {"csv", "bin"};
+    static char const * const clauses[] = {"", " binary format=\"%float64%float64\""};
     char filename_buffer[1024];
-    va_list ap;
-    FILE *fp;
-    va_start(ap, points);
     long double const sampling_interval = (end - start) / ((long double)points);
-    size_t const base_len = strlen(base);
-    memcpy(filename_buffer, base, sizeof(char)*base_len);
-    memcpy(filename_buffer + base_len, "___", sizeof(char) * 3);
-    for(size_t i = 0; i < n_functions; i++) {
-        snprintf(filename_buffer + base_len + 3, 1024 - base_len - 3, "d%ld.csv", i);
-        fp = fopen(filename_buffer, "w");
-        t_f = va_arg(ap, struct function const *);
-        function_names[i] = t_f->name;
-        for(long double x = start; x < end; x += sampling_interval) {
-            fprintf(fp, "%.32LE,%.32LE\n", x, t_f->f(x, t_f->arg));
+    size_t const n_points = gnuplot_points(start, end, sampling_interval);
+    if(options->decimation != GNUPLOT_DECIMATE_NONE && options->target_points >= 4 && options->target_points < n_points) {
+        for(size_t i = 0; i < n_functions; i++) {
+            struct decimation decimation;
+            snprintf(filename_buffer, sizeof(filename_buffer), "%s___d%ld.%s", base, i, extensions[options->format]);
+            if(gnuplot_decimate(options, functions[i], start, sampling_interval, n_points, &decimation) == 0) {
+                gnuplot_write_series(filename_buffer, options->format, decimation.x, decimation.y, decimation.n);
+                free(decimation.x);
+                free(decimation.y);
+            }
+        }
+    } else if(options->format == GNUPLOT_BINARY) {
+        for(size_t i = 0; i < n_functions; i++) {
+            snprintf(filename_buffer, sizeof(filename_buffer), "%s___d%ld.bin", base, i);
+            gnuplot_write_binary(filename_buffer, functions[i], start, end, sampling_interval);
         }
-        fclose(fp);
+    } else {
+        FILE ** const files = malloc(sizeof(FILE*) * n_functions);
+        if(files == NULL) {
+            fprintf(stderr, "gnuplot(): Unable to allocate memory.\n");
+            return;
+        }
+        size_t opened = 0;
+        for(; opened < n_functions; opened++) {
+            snprintf(filename_buffer, sizeof(filename_buffer), "%s___d%ld.csv", base, opened);
+            if((files[opened] = fopen(filename_buffer, "w")) == NULL) {
+                fprintf(stderr, "gnuplot(): Unable to open %s.\n", filename_buffer);
+                break;
+            }
+        }
+        char const written = opened == n_functions && gnuplot_write_csv(files, functions, n_functions, start, end, sampling_interval) == 0;
+        while(opened != 0) {
+            opened--;
+            /* Buffered data is only known to be on disk once fclose() succeeds */
+            if(fclose(files[opened]) != 0 && written) {
+                snprintf(filename_buffer, sizeof(filename_buffer), "%s___d%ld.csv", base, opened);
+                fprintf(stderr, "gnuplot(): Unable to write %s.\n", filename_buffer);
+            }
+        }
+        free(files);
+    }
+    snprintf(filename_buffer, sizeof(filename_buffer), "%s.gnuplot", base);
+    FILE * const fp = fopen(filename_buffer, "w");
+    if(fp == NULL) {
+        fprintf(stderr, "gnuplot(): Unable to open %s.\n", filename_buffer);
+        return;
+    }
+    if(options->format == GNUPLOT_CSV) {
+        fprintf(fp, "set datafile separator \",\";");
     }
-    memcpy(filename_buffer + base_len, ".gnuplot", sizeof(char) * 9);
-    fp = fopen(filename_buffer, "w");
-    fprintf(fp, "set datafile separator \",\";");
     fprintf(fp, "plot ");
     for(size_t i = 0; i < n_functions; i++) {
-        fprintf(fp, "\"%s___d%ld.csv\" using 1:2 title \'%s\' with lines,", base, i, function_names[i]);
+        fprintf(fp, "\"%s___d%ld.%s\"%s using 1:2 title \'%s\' with lines,", base, i, extensions[options->format], clauses[options->format], functions[i]->name);
     }
     fprintf(fp, "\n");
     fclose(fp);
+}
+
+static void vgnuplot(struct gnuplot_options const * const options, char const * const base, size_t const n_functions, long double const start, long double const end, unsigned long const points, va_list ap)
+{
+    struct function const ** const functions = malloc(sizeof(struct function const*) * n_functions);
+    if(functions == NULL) {
+        fprintf(stderr, "gnuplot(): Unable to allocate memory.\n");
+        return;
+    }
+    for(size_t i = 0; i < n_functions; i++) {
+        functions[i] = va_arg(ap, struct function const *);
+    }
+    gnuplot_functions(options, base, n_functions, start, end, points, functions);
+    free(functions);
+}
+
+void gnuplot(char const * const base, size_t const n_functions, long double const start, long double const end, unsigned long points, ...)
+{
+    struct gnuplot_options const options = {GNUPLOT_CSV, GNUPLOT_DECIMATE_NONE, 0};
+    va_list ap;
+    va_start(ap, points);
+    vgnuplot(&options, base, n_functions, start, end, points, ap);
+    va_end(ap);
+}
+
+void gnuplot_with_options(struct gnuplot_options const * const options, char const * const base, size_t const n_functions, long double const start, long double const end, unsigned long points, ...)
+{
+    va_list ap;
+    va_start(ap, points);
+    vgnuplot(options, base, n_functions, start, end, points, ap);
     va_end(ap);
-    free(function_names);
 }
 
+/* Neumaier's variant of Kahan summation: the total is *sum + *compensation */
+static void compensated_add(long double * const sum, long double * const compensation, long double const value)
+{
+    long double const t = *sum + value;
+    if(fabsl(*sum) >= fabsl(value)) {
+        *compensation += (*sum - t) + value;
+    } else {
+        *compensation += (value - t) + *sum;
+    }
+    *sum = t;
+}
+
+struct function_error_part {
+    long double difference2;
+    long double difference2_compensation;
+    long double f2;
+    long double f2_compensation;
+};
+
+struct function_error_job {
+    struct function const* function1;
+    struct function const* function2;
+    long double start;
+    long double sampling_interval;
+    size_t grain;
+    struct function_error_part* parts;
+};
+
+static void function_error_task(size_t const begin, size_t const end, void * const arg)
+{
+    struct function_error_job const * const job = arg;
+    struct function_error_part * const part = &job->parts[begin / job->grain];
+    long double x[SAMPLE_CHUNK], y1[SAMPLE_CHUNK], y2[SAMPLE_CHUNK];
+    part->difference2 = part->difference2_compensation = 0.0L;
+    part->f2 = part->f2_compensation = 0.0L;
+    for(size_t i = begin; i < end; i += SAMPLE_CHUNK) {
+        size_t const chunk = (end - i < SAMPLE_CHUNK) ? end - i : SAMPLE_CHUNK;
+        long double difference2 = 0.0L, f2 = 0.0L;
+        for(size_t j = 0; j != chunk; j++) {
+            x[j] = job->start + (job->sampling_interval * ((long double)(i + j)));
+        }
+        function_values(job->function1, x, y1, chunk);
+        function_values(job->function2, x, y2, chunk);
+        precision_sum_squares(y1, y2, chunk, &difference2, &f2);
+        compensated_add(&part->difference2, &part->difference2_compensation, difference2);
+        compensated_add(&part->f2, &part->f2_compensation, f2);
+    }
+}
+
+/* Relative L2 distance over the same points sample_values() would take.
+ * The points are split in FUNCTION_ERROR_PARTS fixed ranges evaluated in
+ * parallel, and the partial sums are reduced in range order, so the result
+ * does not depend on the number of threads. */
 static long double function_error(struct function const* const function1, struct function const* const function2, long double const start, long double const end, unsigned long const points)
 {
     if(end <= start) {
         return NAN;
     }
-    long double sampling_interval = (end - start) / (long double)points;
-    struct sampled_function* const sampled_function1 = sample_values(function1, start, end, sampling_interval);
-    if(sampled_function1 == NULL) {
-        fprintf(stderr, "function_error(): Unable to take samples.\n");
-        return NAN;
+    long double const sampling_interval = (end - start) / (long double)points;
+    size_t const n_samples = (size_t)(floorl((end - start) / sampling_interval) + 1.0L);
+    struct function_error_part parts[FUNCTION_ERROR_PARTS];
+    size_t grain = (n_samples + FUNCTION_ERROR_PARTS - 1) / FUNCTION_ERROR_PARTS;
+    if(grain < SAMPLE_CHUNK) {
+        grain = SAMPLE_CHUNK;
     }
-    struct sampled_function* const sampled_function2 = sample_values(function2, start, end, sampling_interval);
-    if(sampled_function2 == NULL) {
-        destroy_sample(sampled_function1);
-        fprintf(stderr, "function_error(): Unable to take samples.\n");
-        return NAN;
+    struct function_error_job job = {
+        function1,
+        function2,
+        start,
+        sampling_interval,
+        grain,
+        parts
+    };
+    parallel_for(n_samples, grain, function_error_task, &job);
+
+    long double difference2 = 0.0L, difference2_compensation = 0.0L;
+    long double f2 = 0.0L, f2_compensation = 0.0L;
+    for(size_t i = 0; i != (n_samples + grain - 1) / grain; i++) {
+        compensated_add(&difference2, &difference2_compensation, parts[i].difference2);
+        compensated_add(&difference2, &difference2_compensation, parts[i].difference2_compensation);
+        compensated_add(&f2, &f2_compensation, parts[i].f2);
+        compensated_add(&f2, &f2_compensation, parts[i].f2_compensation);
     }
-    /* Let's be on the safe side */
-    size_t const actual_points = (sampled_function1->n_samples < sampled_function2->n_samples) ? sampled_function1->n_samples : sampled_function2->n_samples;
-    long double difference2 = 0.0L;
-    long double f2 = 0.0L;
-    long double error;
+    return sqrtl((difference2 + difference2_compensation) / (f2 + f2_compensation));
+}
+
+/* Gauss-Kronrod 7/15 abscissae and weights on [-1, 1]. Odd xgk entries are
+ * also the Gauss nodes, with weights wg (the last one for the centre). */
+static long double const gk15_xgk[8] = {
+    0.991455371120812639206854697526329L,
+    0.949107912342758524526189684047851L,
+    0.864864423359769072789712788640926L,
+    0.741531185599394439863864773280788L,
+    0.586087235467691130294144845693013L,
+    0.405845151377397166906606412076961L,
+    0.207784955007898467600689403773245L,
+    0.000000000000000000000000000000000L
+};
+static long double const gk15_wgk[8] = {
+    0.022935322010529224963732008058970L,
+    0.063092092629978553290700663189204L,
+    0.104790010322250183839876322541518L,
+    0.140653259715525918745189590510238L,
+    0.169004726639267902826583426598550L,
+    0.190350578064785409913256402421014L,
+    0.204432940075298892414161999234649L,
+    0.209482141084727828012999174891714L
+};
+static long double const gk15_wg[4] = {
+    0.129484966168869693270611432679082L,
+    0.279705391489276667901467771423780L,
+    0.381830050505118944950369775488975L,
+    0.417959183673469387755102040816327L
+};
 
-    for(size_t i = 0; i < actual_points; i++) {
-        difference2 += powl(sampled_function1->samples[i] - sampled_function2->samples[i], 2.0L);
-        f2 += powl(sampled_function1->samples[i], 2.0L);
+/* ∫(f1 - f2)² and ∫f1² over [a, b] with their error estimates */
+struct quadrature_interval {
+    long double a;
+    long double b;
+    long double difference2;
+    long double difference2_error;
+    long double f2;
+    long double f2_error;
+};
+
+static void gauss_kronrod_15(long double const * const v, long double const half, long double * const integral, long double * const error)
+{
+    long double kronrod = gk15_wgk[7] * v[7];
+    long double gauss = gk15_wg[3] * v[7];
+    for(size_t k = 0; k != 7; k++) {
+        kronrod += gk15_wgk[k] * (v[k] + v[14 - k]);
+    }
+    for(size_t j = 0; j != 3; j++) {
+        gauss += gk15_wg[j] * (v[2 * j + 1] + v[13 - 2 * j]);
     }
-    error = sqrtl(difference2 / f2);
-    destroy_sample(sampled_function1);
-    destroy_sample(sampled_function2);
-    return error;
+    *integral = kronrod * half;
+    *error = fabsl(kronrod - gauss) * half;
+}
+
+static void quadrature_interval_evaluate(struct function const * const function1, struct function const * const function2, struct quadrature_interval * const interval)
+{
+    long double const center = 0.5L * (interval->a + interval->b);
+    long double const half = 0.5L * (interval->b - interval->a);
+    long double x[15], y1[15], y2[15];
+    x[7] = center;
+    for(size_t k = 0; k != 7; k++) {
+        x[k] = center - half * gk15_xgk[k];
+        x[14 - k] = center + half * gk15_xgk[k];
+    }
+    function_values(function1, x, y1, 15);
+    function_values(function2, x, y2, 15);
+    for(size_t k = 0; k != 15; k++) {
+        long double const d = y1[k] - y2[k];
+        y2[k] = d * d;
+        y1[k] = y1[k] * y1[k];
+    }
+    gauss_kronrod_15(y2, half, &interval->difference2, &interval->difference2_error);
+    gauss_kronrod_15(y1, half, &interval->f2, &interval->f2_error);
+}
+
+/* Relative L2 distance sqrt(∫(f1 - f2)² / ∫f1²) by globally adaptive
+ * Gauss-Kronrod quadrature. [start, end] is first split in initial_intervals
+ * equal parts (typically at the interpolation nodes, where the interpolants
+ * have kinks), then the interval contributing most to the error is bisected
+ * until both integrals are within tolerance (relative) or
+ * QUADRATURE_MAX_INTERVALS is reached. iterations counts the bisections and
+ * evaluations the evaluations of function1 and function2. */
+static struct result function_error_adaptive(struct function const * const function1, struct function const * const function2, long double const start, long double const end, size_t initial_intervals, long double const tolerance)
+{
+    struct result result = {NAN, NAN, 0, 0};
+    if(end <= start) {
+        return result;
+    }
+    if(initial_intervals == 0) {
+        initial_intervals = 1;
+    } else if(initial_intervals > QUADRATURE_MAX_INTERVALS) {
+        initial_intervals = QUADRATURE_MAX_INTERVALS;
+    }
+    struct quadrature_interval * const intervals = malloc(sizeof(struct quadrature_interval) * QUADRATURE_MAX_INTERVALS);
+    if(intervals == NULL) {
+        fprintf(stderr, "function_error_adaptive(): Unable to allocate memory.\n");
+        return result;
+    }
+    size_t n = initial_intervals;
+    long double const width = (end - start) / (long double)initial_intervals;
+    for(size_t i = 0; i != n; i++) {
+        intervals[i].a = start + width * (long double)i;
+        intervals[i].b = (i + 1 == n) ? end : start + width * (long double)(i + 1);
+        quadrature_interval_evaluate(function1, function2, &intervals[i]);
+    }
+    for(;;) {
+        long double difference2 = 0.0L, difference2_error = 0.0L, f2 = 0.0L, f2_error = 0.0L;
+        for(size_t i = 0; i != n; i++) {
+            difference2 += intervals[i].difference2;
+            difference2_error += intervals[i].difference2_error;
+            f2 += intervals[i].f2;
+            f2_error += intervals[i].f2_error;
+        }
+        /* A difference far below the working precision of f2 is as good as zero */
+        long double const difference2_tolerance = fmaxl(tolerance * difference2, LDBL_EPSILON * LDBL_EPSILON * f2);
+        char const converged = difference2_error <= difference2_tolerance && f2_error <= tolerance * f2;
+        if(converged || n == QUADRATURE_MAX_INTERVALS) {
+            result.value = sqrtl(difference2 / f2);
+            /* The relative bound is 0/0 for an exact fit; the difference is then at most its own error */
+            if(difference2 > 0.0L) {
+                result.error = 0.5L * result.value * (difference2_error / difference2 + f2_error / f2);
+            } else {
+                result.error = sqrtl(difference2_error / f2);
+            }
+            break;
+        }
+        size_t worst = 0;
+        long double worst_error = -1.0L;
+        for(size_t i = 0; i != n; i++) {
+            long double const e = intervals[i].difference2_error / difference2_tolerance + intervals[i].f2_error / (tolerance * f2);
+            if(e > worst_error) {
+                worst = i;
+                worst_error = e;
+            }
+        }
+        long double const middle = 0.5L * (intervals[worst].a + intervals[worst].b);
+        intervals[n].a = middle;
+        intervals[n].b = intervals[worst].b;
+        intervals[worst].b = middle;
+        quadrature_interval_evaluate(function1, function2, &intervals[worst]);
+        quadrature_interval_evaluate(function1, function2, &intervals[n]);
+        n++;
+    }
+    /* Every bisection added one interval. Every interval, including
+     * discarded halves, cost 15 points of each function */
+    result.iterations = n - initial_intervals;
+    result.evaluations = 30 * (2 * n - initial_intervals);
+    free(intervals);
+    return result;
 }
 
 struct interpolation* allocate_interpolation(struct function const * const function, long double const start, long double const end, size_t const order) {
@@ -204,6 +935,10 @@ struct interpolation* allocate_interpolation(struct function const * const funct
         interpolation->end = end;
         interpolation->order = order;
         interpolation->name = NULL;
+        interpolation->nodes = NULL;
+        interpolation->weights = NULL;
+        interpolation->grid = NULL;
+        interpolation->moments = NULL;
     }
     return interpolation;
 }
@@ -212,18 +947,47 @@ void destroy_interpolation(struct interpolation* const interpolation)
 {
     free(interpolation->name);
     free(interpolation->coefficients);
+    free(interpolation->nodes);
+    free(interpolation->weights);
+    free(interpolation->moments);
+    if(interpolation->grid != NULL) {
+        destroy_grid_evaluator(interpolation->grid);
+    }
     free(interpolation);
 }
 
+/* Horner's rule is one serial chain of multiply-adds. Above
+ * POLYNOMIAL_ESTRIN_ORDER the first level of Estrin's scheme is used instead:
+ * even and odd coefficients run as two independent Horner chains in x**2,
+ * joined as even + x * odd. Deeper levels only add x87 register spills.
+ * precision_polynomial_values() follows the same scheme, so in long double
+ * the batch and scalar paths round identically. */
 long double polynomial_value(long double const x, struct interpolation const * const interpolation)
 {
-    long double y = interpolation->coefficients[0];
-    long double xn = x;
-    for(size_t i = 1; i <= interpolation->order; i++) {
-        y += interpolation->coefficients[i] * xn;
-        xn *= x;
+    size_t const order = interpolation->order;
+    long double const * const coefficients = interpolation->coefficients;
+    if(order <= POLYNOMIAL_ESTRIN_ORDER) {
+        long double y = coefficients[order];
+        for(size_t i = order; i != 0; i--) {
+            y = y * x + coefficients[i - 1];
+        }
+        return y;
+    }
+    long double const x2 = x * x;
+    size_t const even_top = order & ~(size_t)1, odd_top = (order & 1) ? order : order - 1;
+    long double even = coefficients[even_top], odd = coefficients[odd_top];
+    for(size_t i = even_top; i >= 2; i -= 2) {
+        even = even * x2 + coefficients[i - 2];
     }
-    return y;
+    for(size_t i = odd_top; i >= 3; i -= 2) {
+        odd = odd * x2 + coefficients[i - 2];
+    }
+    return even + x * odd;
+}
+
+void polynomial_values(long double const * const x, long double * const y, size_t const n, struct interpolation const * const interpolation)
+{
+    precision_polynomial_values(interpolation->coefficients, interpolation->order, x, y, n);
 }
 
 long double polynomial_error(struct interpolation const * const interpolation)
@@ -231,22 +995,31 @@ long double polynomial_error(struct interpolation const * const interpolation)
     struct function const function2 = {
         interpolation->name,
         (long double(*)(long double, void const*))polynomial_value,
-        interpolation
+        interpolation,
+        (void(*)(long double const*, long double*, size_t, void const*))polynomial_values
     };
     return function_error(interpolation->function, &function2, interpolation->start, interpolation->end, interpolation->order * POLYNOMIAL_ERROR_POINT_MULTIPLIER + 1);
 }
 
+struct result polynomial_error_adaptive(struct interpolation const * const interpolation, long double const tolerance)
+{
+    struct function const function2 = {
+        interpolation->name,
+        (long double(*)(long double, void const*))polynomial_value,
+        interpolation,
+        (void(*)(long double const*, long double*, size_t, void const*))polynomial_values
+    };
+    return function_error_adaptive(interpolation->function, &function2, interpolation->start, interpolation->end, interpolation->order, tolerance);
+}
+
 long double piecewise_linear_value(long double const x, struct interpolation const * const interpolation)
 {
-    if(x < interpolation->start || x > interpolation->end) {
-        return NAN;
-    }
-    long double const sampling_interval = interpolation->sampling_interval;
-    long double const x_sample = x - interpolation->start;
-    size_t const x0 = (size_t)floorl(x_sample / sampling_interval);
-    size_t const x1 = (size_t)ceill(x_sample / sampling_interval);
-    long double const a = sampling_interval * ((long double)x0 + 1.0L) - x_sample, b = sampling_interval * ((long double)x0) - x_sample;
-    return interpolation->coefficients[x0] * a - interpolation->coefficients[x1] * b;
+    return grid_evaluator_value(interpolation->grid, x);
+}
+
+void piecewise_linear_values(long double const * const x, long double * const y, size_t const n, struct interpolation const * const interpolation)
+{
+    grid_evaluator_values(interpolation->grid, x, y, n);
 }
 
 long double piecewise_linear_error(struct interpolation const * const interpolation)
@@ -254,23 +1027,31 @@ long double piecewise_linear_error(struct interpolation const * const interpolat
     struct function const function2 = {
         interpolation->name,
         (long double(*)(long double, void const*))piecewise_linear_value,
-        interpolation
+        interpolation,
+        (void(*)(long double const*, long double*, size_t, void const*))piecewise_linear_values
     };
     return function_error(interpolation->function, &function2, interpolation->start, interpolation->end, interpolation->order * POLYNOMIAL_ERROR_POINT_MULTIPLIER + 1);
 }
 
+struct result piecewise_linear_error_adaptive(struct interpolation const * const interpolation, long double const tolerance)
+{
+    struct function const function2 = {
+        interpolation->name,
+        (long double(*)(long double, void const*))piecewise_linear_value,
+        interpolation,
+        (void(*)(long double const*, long double*, size_t, void const*))piecewise_linear_values
+    };
+    return function_error_adaptive(interpolation->function, &function2, interpolation->start, interpolation->end, interpolation->order, tolerance);
+}
+
 long double raised_cosine_value(long double const x, struct interpolation const * const interpolation)
 {
-    if(x < interpolation->start || x > interpolation->end) {
-        return NAN;
-    }
-    long double const sampling_interval = interpolation->sampling_interval;
-    long double const x_sample = x - interpolation->start;
-    size_t const x0 = (size_t)floorl(x_sample / sampling_interval);
-    size_t const x1 = (size_t)ceill(x_sample / sampling_interval);
-    long double const a = x_sample / sampling_interval - ((long double)x0);
-    long double const b = x_sample / sampling_interval - ((long double)x0 + 1.0L);
-    return interpolation->coefficients[x0] * (1.0L + cosl(M_PI * a)) + interpolation->coefficients[x1] * (1.0L + cosl(M_PI * b));
+    return grid_evaluator_value(interpolation->grid, x);
+}
+
+void raised_cosine_values(long double const * const x, long double * const y, size_t const n, struct interpolation const * const interpolation)
+{
+    grid_evaluator_values(interpolation->grid, x, y, n);
 }
 
 long double raised_cosine_error(struct interpolation const * const interpolation)
@@ -278,7 +1059,231 @@ long double raised_cosine_error(struct interpolation const * const interpolation
     struct function const function2 = {
         interpolation->name,
         (long double(*)(long double, void const*))raised_cosine_value,
-        interpolation
+        interpolation,
+        (void(*)(long double const*, long double*, size_t, void const*))raised_cosine_values
+    };
+    return function_error(interpolation->function, &function2, interpolation->start, interpolation->end, interpolation->order * POLYNOMIAL_ERROR_POINT_MULTIPLIER + 1);
+}
+
+struct result raised_cosine_error_adaptive(struct interpolation const * const interpolation, long double const tolerance)
+{
+    struct function const function2 = {
+        interpolation->name,
+        (long double(*)(long double, void const*))raised_cosine_value,
+        interpolation,
+        (void(*)(long double const*, long double*, size_t, void const*))raised_cosine_values
+    };
+    return function_error_adaptive(interpolation->function, &function2, interpolation->start, interpolation->end, interpolation->order, tolerance);
+}
+
+/* Barycentric formula with the 1 / (x - x_j) factors replaced by products
+ * of the other differences:
+ * Σ w_j f_j Π_{k != j} (x - x_k) / Σ w_j Π_{k != j} (x - x_k).
+ * Both sums are built in one pass over the nodes, like Horner's rule: after
+ * node j each is multiplied by x - x_j and gains the term of node j times the
+ * product of the earlier differences. Every BARYCENTRIC_RESCALE_NODES nodes
+ * all three are divided by that product, which leaves the ratio alone and
+ * keeps them in range. That is O(order) multiplies, no scratch and few
+ * divisions. At a node the sample is returned as is. */
+long double barycentric_value(long double const x, struct interpolation const * const interpolation)
+{
+    size_t const n = interpolation->order + 1;
+    long double const * const nodes = interpolation->nodes;
+    long double const * const weights = interpolation->weights;
+    long double numerator = 0.0L, denominator = 0.0L, product = 1.0L;
+    for(size_t j = 0; j != n; j++) {
+        long double const d = x - nodes[j];
+        if(d == 0.0L) {
+            return interpolation->coefficients[j];
+        }
+        long double const t = weights[j] * product;
+        numerator = numerator * d + t * interpolation->coefficients[j];
+        denominator = denominator * d + t;
+        product *= d;
+        if((j + 1) % BARYCENTRIC_RESCALE_NODES == 0) {
+            long double const scale = (product != 0.0L) ? 1.0L / product : 1.0L;
+            numerator *= scale;
+            denominator *= scale;
+            product *= scale;
+        }
+    }
+    return numerator / denominator;
+}
+
+void barycentric_values(long double const * const x, long double * const y, size_t const n, struct interpolation const * const interpolation)
+{
+    precision_barycentric_values(interpolation->nodes, interpolation->weights, interpolation->coefficients, interpolation->order + 1, x, y, n);
+}
+
+long double barycentric_error(struct interpolation const * const interpolation)
+{
+    struct function const function2 = {
+        interpolation->name,
+        (long double(*)(long double, void const*))barycentric_value,
+        interpolation,
+        (void(*)(long double const*, long double*, size_t, void const*))barycentric_values
+    };
+    return function_error(interpolation->function, &function2, interpolation->start, interpolation->end, interpolation->order * POLYNOMIAL_ERROR_POINT_MULTIPLIER + 1);
+}
+
+struct result barycentric_error_adaptive(struct interpolation const * const interpolation, long double const tolerance)
+{
+    struct function const function2 = {
+        interpolation->name,
+        (long double(*)(long double, void const*))barycentric_value,
+        interpolation,
+        (void(*)(long double const*, long double*, size_t, void const*))barycentric_values
+    };
+    return function_error_adaptive(interpolation->function, &function2, interpolation->start, interpolation->end, interpolation->order, tolerance);
+}
+
+/* Clenshaw's recurrence for Σ c_j T_j(t), t being x mapped to [-1, 1] */
+long double chebyshev_value(long double const x, struct interpolation const * const interpolation)
+{
+    long double const t = (2.0L * x - (interpolation->start + interpolation->end)) / (interpolation->end - interpolation->start);
+    long double const t2 = 2.0L * t;
+    long double b1 = 0.0L, b2 = 0.0L;
+    for(size_t j = interpolation->order; j != 0; j--) {
+        long double const b0 = interpolation->coefficients[j] + t2 * b1 - b2;
+        b2 = b1;
+        b1 = b0;
+    }
+    return interpolation->coefficients[0] + t * b1 - b2;
+}
+
+void chebyshev_values(long double const * const x, long double * const y, size_t const n, struct interpolation const * const interpolation)
+{
+    for(size_t i = 0; i != n; i++) {
+        y[i] = chebyshev_value(x[i], interpolation);
+    }
+}
+
+long double chebyshev_error(struct interpolation const * const interpolation)
+{
+    struct function const function2 = {
+        interpolation->name,
+        (long double(*)(long double, void const*))chebyshev_value,
+        interpolation,
+        (void(*)(long double const*, long double*, size_t, void const*))chebyshev_values
+    };
+    return function_error(interpolation->function, &function2, interpolation->start, interpolation->end, interpolation->order * POLYNOMIAL_ERROR_POINT_MULTIPLIER + 1);
+}
+
+struct result chebyshev_error_adaptive(struct interpolation const * const interpolation, long double const tolerance)
+{
+    struct function const function2 = {
+        interpolation->name,
+        (long double(*)(long double, void const*))chebyshev_value,
+        interpolation,
+        (void(*)(long double const*, long double*, size_t, void const*))chebyshev_values
+    };
+    return function_error_adaptive(interpolation->function, &function2, interpolation->start, interpolation->end, interpolation->order, tolerance);
+}
+
+/* With t the position within cell i in [0, 1] and m the scaled moments,
+ * S = y_i + t (y_i+1 - y_i - 2 m_i - m_i+1) + 3 m_i t**2 + (m_i+1 - m_i) t**3.
+ * Cell i is the last one whose left end, start + i h, is <= x; t is measured
+ * from that end */
+struct cubic_spline_cell {
+    long double left;
+    long double a, b, c, d;
+};
+
+static inline void cubic_spline_cell(struct interpolation const * const interpolation, size_t const cell, struct cubic_spline_cell * const out)
+{
+    long double const * const y = interpolation->coefficients + cell;
+    long double const * const m = interpolation->moments + cell;
+    out->left = interpolation->start + interpolation->sampling_interval * (long double)cell;
+    out->a = y[0];
+    out->b = y[1] - y[0] - 2.0L * m[0] - m[1];
+    out->c = 3.0L * m[0];
+    out->d = m[1] - m[0];
+}
+
+static inline long double cubic_spline_cell_value(struct cubic_spline_cell const * const cell, long double const x, long double const inverse_interval)
+{
+    long double const t = (x - cell->left) * inverse_interval;
+    return cell->a + t * (cell->b + t * (cell->c + t * cell->d));
+}
+
+/* The cell estimated from (x - start) / h is off by at most one at a cell
+ * edge, so it is settled against the edges themselves */
+static long double cubic_spline_evaluate(long double const x, struct interpolation const * const interpolation, long double const inverse_interval)
+{
+    size_t const cells = interpolation->order;
+    long double const s = (x - interpolation->start) * inverse_interval;
+    size_t cell = ((size_t)s < cells) ? (size_t)s : cells - 1;
+    if(cell + 1 < cells && x >= interpolation->start + interpolation->sampling_interval * (long double)(cell + 1)) {
+        cell++;
+    } else if(cell != 0 && x < interpolation->start + interpolation->sampling_interval * (long double)cell) {
+        cell--;
+    }
+    struct cubic_spline_cell spline_cell;
+    cubic_spline_cell(interpolation, cell, &spline_cell);
+    return cubic_spline_cell_value(&spline_cell, x, inverse_interval);
+}
+
+long double cubic_spline_value(long double const x, struct interpolation const * const interpolation)
+{
+    if(!(x >= interpolation->start && x <= interpolation->end)) {
+        return NAN;
+    }
+    return cubic_spline_evaluate(x, interpolation, 1.0L / interpolation->sampling_interval);
+}
+
+/* A batch in ascending order, as sampling and the error integrals pass, is
+ * range checked at its ends only and walks the cells forward, building each
+ * cell's cubic once, so a point costs a compare and four multiply-adds. Any
+ * other batch goes point by point. Both give the same values as
+ * cubic_spline_value(). */
+void cubic_spline_values(long double const * const x, long double * const y, size_t const n, struct interpolation const * const interpolation)
+{
+    long double const inverse_interval = 1.0L / interpolation->sampling_interval;
+    char sorted = n != 0 && x[0] >= interpolation->start && x[n - 1] <= interpolation->end;
+    for(size_t i = 1; i < n && sorted; i++) {
+        sorted = x[i - 1] <= x[i];
+    }
+    if(!sorted) {
+        for(size_t i = 0; i != n; i++) {
+            y[i] = (x[i] >= interpolation->start && x[i] <= interpolation->end) ? cubic_spline_evaluate(x[i], interpolation, inverse_interval) : NAN;
+        }
+        return;
+    }
+    size_t const cells = interpolation->order;
+    size_t cell = 0;
+    long double right = interpolation->start + interpolation->sampling_interval;
+    struct cubic_spline_cell spline_cell;
+    cubic_spline_cell(interpolation, cell, &spline_cell);
+    for(size_t i = 0; i != n; i++) {
+        if(x[i] >= right && cell + 1 < cells) {
+            do {
+                cell++;
+                right = interpolation->start + interpolation->sampling_interval * (long double)(cell + 1);
+            } while(x[i] >= right && cell + 1 < cells);
+            cubic_spline_cell(interpolation, cell, &spline_cell);
+        }
+        y[i] = cubic_spline_cell_value(&spline_cell, x[i], inverse_interval);
+    }
+}
+
+long double cubic_spline_error(struct interpolation const * const interpolation)
+{
+    struct function const function2 = {
+        interpolation->name,
+        (long double(*)(long double, void const*))cubic_spline_value,
+        interpolation,
+        (void(*)(long double const*, long double*, size_t, void const*))cubic_spline_values
     };
     return function_error(interpolation->function, &function2, interpolation->start, interpolation->end, interpolation->order * POLYNOMIAL_ERROR_POINT_MULTIPLIER + 1);
 }
+
+struct result cubic_spline_error_adaptive(struct interpolation const * const interpolation, long double const tolerance)
+{
+    struct function const function2 = {
+        interpolation->name,
+        (long double(*)(long double, void const*))cubic_spline_value,
+        interpolation,
+        (void(*)(long double const*, long double*, size_t, void const*))cubic_spline_values
+    };
+    return function_error_adaptive(interpolation->function, &function2, interpolation->start, interpolation->end, interpolation->order, tolerance);
+}
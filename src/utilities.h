@@ -20,13 +20,17 @@
  THE SOFTWARE.
 */
 
+#include <stdio.h>
 #include <string.h>
 #include "matrix.h"
+#include "grid.h"
 
 struct function {
     char const* name;
     long double(*f)(long double, void const*);
     void const* arg;
+    /* Optional: evaluates n points at once; NULL falls back to f */
+    void(*f_batch)(long double const* x, long double* y, size_t n, void const*);
 };
 
 struct sampled_function {
@@ -43,6 +47,10 @@ struct result {
     long double error;
     unsigned long iterations;
     unsigned char convergence_rate;
+    /* Only filled in by instrument_result() and the *_error_adaptive()
+     * functions, 0 otherwise; time is in seconds */
+    unsigned long evaluations;
+    long double time;
 };
 
 struct interpolation {
@@ -51,28 +59,95 @@ struct interpolation {
     long double start;
     long double end;
     size_t order;
+    /* NULL for piecewise linear and raised cosine, which evaluate through grid */
     long double *coefficients;
     long double sampling_interval;
+    /* Barycentric forms only: interpolation nodes and their weights */
+    long double *nodes;
+    long double *weights;
+    /* Piecewise linear and raised cosine only */
+    struct grid_evaluator *grid;
+    /* Cubic splines only: second derivatives at the samples, times sampling_interval**2 / 6 */
+    long double *moments;
+};
+
+enum interpolation_nodes {
+    INTERPOLATION_NODES_UNIFORM,
+    /* Chebyshev points of the second kind, cos(j pi / order) mapped to [start, end] */
+    INTERPOLATION_NODES_CHEBYSHEV
 };
 
 // struct linear_interpolation
 // struct raised_cosine_interpolation
 // struct least_squares_interpolation
 
+void function_values(struct function const*, long double const* x, long double* y, size_t n);
+
 struct sampled_function* sample_values(struct function const*, long double, long double, long double);
 void destroy_sample(struct sampled_function*);
 
 struct sampled_function* sample_derivative(struct sampled_function const*);
 
 void report_result(struct result const*);
+void fprint_result(FILE*, struct result const*);
+
+enum gnuplot_format {
+    GNUPLOT_CSV,
+    /* Native float64 (x, y) pairs, read with binary format="%float64%float64" */
+    GNUPLOT_BINARY
+};
 
+/* Decimation still evaluates every point but only writes target_points of
+ * them: the minimum and maximum of each of target_points / 2 buckets, which
+ * keeps every spike, or the largest-triangle-three-buckets selection */
+enum gnuplot_decimation {
+    GNUPLOT_DECIMATE_NONE,
+    GNUPLOT_DECIMATE_MINMAX,
+    GNUPLOT_DECIMATE_LTTB
+};
+
+struct gnuplot_options {
+    enum gnuplot_format format;
+    enum gnuplot_decimation decimation;
+    size_t target_points;
+};
+
+/* Writes base___d<i>.csv (or .bin) for each of the n_functions struct function
+ * const* arguments, and a base.gnuplot script plotting them. gnuplot() uses CSV */
 void gnuplot(char const * base, size_t n_functions, long double start, long double end, unsigned long points, ...);
+void gnuplot_with_options(struct gnuplot_options const* options, char const * base, size_t n_functions, long double start, long double end, unsigned long points, ...);
+/* Same, taking the functions as an array */
+void gnuplot_functions(struct gnuplot_options const* options, char const * base, size_t n_functions, long double start, long double end, unsigned long points, struct function const * const * functions);
+
+/* The *_error() functions estimate the relative L2 error of an interpolation
+ * from order * 524288 + 1 uniform samples; the *_error_adaptive() variants
+ * use adaptive Gauss-Kronrod quadrature instead, returning the estimate in
+ * value, its uncertainty in error, the intervals bisected in iterations and
+ * the function evaluations used in evaluations. */
 
 struct interpolation* allocate_interpolation(struct function const*, long double start, long double end, size_t order);
 void destroy_interpolation(struct interpolation*);
 long double polynomial_value(long double x, struct interpolation const *interpolation);
+void polynomial_values(long double const* x, long double* y, size_t n, struct interpolation const *interpolation);
 long double polynomial_error(struct interpolation const*);
+struct result polynomial_error_adaptive(struct interpolation const*, long double tolerance);
 long double piecewise_linear_value(long double x, struct interpolation const *interpolation);
+void piecewise_linear_values(long double const* x, long double* y, size_t n, struct interpolation const *interpolation);
 long double piecewise_linear_error(struct interpolation const*);
+struct result piecewise_linear_error_adaptive(struct interpolation const*, long double tolerance);
 long double raised_cosine_value(long double x, struct interpolation const *interpolation);
-long double raised_cosine_error(struct interpolation const*);
\ No newline at end of file
+void raised_cosine_values(long double const* x, long double* y, size_t n, struct interpolation const *interpolation);
+long double raised_cosine_error(struct interpolation const*);
+struct result raised_cosine_error_adaptive(struct interpolation const*, long double tolerance);
+long double barycentric_value(long double x, struct interpolation const *interpolation);
+void barycentric_values(long double const* x, long double* y, size_t n, struct interpolation const *interpolation);
+long double barycentric_error(struct interpolation const*);
+struct result barycentric_error_adaptive(struct interpolation const*, long double tolerance);
+long double chebyshev_value(long double x, struct interpolation const *interpolation);
+void chebyshev_values(long double const* x, long double* y, size_t n, struct interpolation const *interpolation);
+long double chebyshev_error(struct interpolation const*);
+struct result chebyshev_error_adaptive(struct interpolation const*, long double tolerance);
+long double cubic_spline_value(long double x, struct interpolation const *interpolation);
+void cubic_spline_values(long double const* x, long double* y, size_t n, struct interpolation const *interpolation);
+long double cubic_spline_error(struct interpolation const*);
+struct result cubic_spline_error_adaptive(struct interpolation const*, long double tolerance);
\ No newline at end of file